@@ -70,6 +70,7 @@ static stream *conn = NULL;
 static char hostname[128];
 static char *filename = NULL;
 static int beat = 0;
+static int sample = 0;
 static int json = 0;
 static Mapi dbh;
 static MapiHdl hdl = NULL;
@@ -233,6 +234,7 @@ usageStethoscope(void)
     fprintf(stderr, "  -j | --json\n");
     fprintf(stderr, "  -o | --output=<file>\n");
     fprintf(stderr, "  -b | --beat=<delay> in milliseconds (default 50)\n");
+    fprintf(stderr, "  -s | --sample=<n> compact events of one out of every n queries\n");
     fprintf(stderr, "  -D | --debug\n");
     fprintf(stderr, "  -? | --help\n");
     exit(-1);
@@ -277,7 +279,7 @@ main(int argc, char **argv)
 	int done = 0;
 	EventRecord *ev = calloc(1, sizeof(EventRecord));
 
-	static struct option long_options[13] = {
+	static struct option long_options[14] = {
 		{ "dbname", 1, 0, 'd' },
 		{ "user", 1, 0, 'u' },
 		{ "port", 1, 0, 'p' },
@@ -290,6 +292,7 @@ main(int argc, char **argv)
 		{ "output", 1, 0, 'o' },
 		{ "debug", 0, 0, 'D' },
 		{ "beat", 1, 0, 'b' },
+		{ "sample", 1, 0, 's' },
 		{ 0, 0, 0, 0 }
 	};
 
@@ -303,7 +306,7 @@ main(int argc, char **argv)
 
 	while (1) {
 		int option_index = 0;
-		int c = getopt_long(argc, argv, "d:u:p:P:h:?jyo:Db:",
+		int c = getopt_long(argc, argv, "d:u:p:P:h:?jyo:Db:s:",
 					long_options, &option_index);
 		if (c == -1)
 			break;
@@ -314,6 +317,9 @@ main(int argc, char **argv)
 		case 'b':
 			beat = atoi(optarg ? optarg : "5000");
 			break;
+		case 's':
+			sample = atoi(optarg ? optarg : "1");
+			break;
 		case 'd':
 			if (dbname)
 				free(dbname);
@@ -420,7 +426,10 @@ main(int argc, char **argv)
 		fprintf(stderr,"-- %s\n",buf);
 	doQ(buf);
 
-	snprintf(buf, BUFSIZ, "profiler.openstream();");
+	if (sample > 0)
+		snprintf(buf, BUFSIZ, "profiler.openstream(%d);", sample);
+	else
+		snprintf(buf, BUFSIZ, "profiler.openstream();");
 	if( debug)
 		fprintf(stderr,"--%s\n",buf);
 	doQ(buf);
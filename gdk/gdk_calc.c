@@ -14368,3 +14368,190 @@ VARconvert(ValPtr ret, const ValRecord *v, bool abort_on_error)
 	ret->len = ATOMlen(ret->vtype, VALptr(ret));
 	return nils == BUN_NONE ? GDK_FAIL : GDK_SUCCEED;
 }
+
+/* ---------------------------------------------------------------------- */
+/* fused calculations */
+
+/* Evaluate a tree of arithmetic operations and conversions in a
+ * single pass over the inputs.  The inputs are processed in vectors
+ * of CALCVECTOR values, and the intermediate results of all but the
+ * last step are kept in small vector sized buffers, so that they stay
+ * in the CPU cache and no BAT is materialized for them.  Each step is
+ * evaluated by the same type specific loop as the corresponding
+ * BATcalc function, so the result (including error behavior) is
+ * identical to executing the steps one by one.
+ *
+ * Argument i is the BAT b[i], or, if b[i] is NULL, the constant v[i].
+ * All BAT arguments must be aligned.  The last step produces the
+ * result. */
+
+#define CALCVECTOR	1024
+
+BAT *
+BATcalcfused(BAT **b, const ValRecord *v, int nargs, const calcstep *steps, int nsteps, bool abort_on_error)
+{
+	BAT *bn, *b1 = NULL;
+	BUN cnt, off, n, nils = 0, r;
+	void **vec;
+	int i, k, tp;
+
+	if (nsteps <= 0 || nargs <= 0) {
+		GDKerror("%s: nothing to calculate.\n", __func__);
+		return NULL;
+	}
+	for (i = 0; i < nargs; i++) {
+		if (b[i] == NULL)
+			continue;
+		if (ATOMstorage(b[i]->ttype) == TYPE_void ||
+		    ATOMstorage(b[i]->ttype) >= TYPE_str) {
+			GDKerror("%s: type %s not supported.\n", __func__,
+				 ATOMname(b[i]->ttype));
+			return NULL;
+		}
+		if (b1 == NULL)
+			b1 = b[i];
+		else if (checkbats(b1, b[i], __func__) != GDK_SUCCEED)
+			return NULL;
+	}
+	if (b1 == NULL) {
+		GDKerror("%s: at least one argument must be a BAT.\n", __func__);
+		return NULL;
+	}
+	for (k = 0; k < nsteps; k++) {
+		if (steps[k].lft < 0 || steps[k].lft >= nargs + k ||
+		    (steps[k].op != 'c' &&
+		     (steps[k].rgt < 0 || steps[k].rgt >= nargs + k))) {
+			GDKerror("%s: step %d refers to an unknown operand.\n",
+				 __func__, k);
+			return NULL;
+		}
+	}
+
+	tp = steps[nsteps - 1].tp;
+	cnt = BATcount(b1);
+	bn = COLnew(b1->hseqbase, tp, cnt, TRANSIENT);
+	if (bn == NULL)
+		return NULL;
+	vec = GDKzalloc(nsteps * sizeof(void *));
+	if (vec == NULL) {
+		BBPunfix(bn->batCacheid);
+		return NULL;
+	}
+	for (k = 0; k < nsteps - 1; k++) {
+		if ((vec[k] = GDKmalloc(CALCVECTOR * ATOMsize(steps[k].tp))) == NULL)
+			goto bailout;
+	}
+
+	for (off = 0; off < cnt; off += n) {
+		n = cnt - off < CALCVECTOR ? cnt - off : CALCVECTOR;
+		for (k = 0; k < nsteps; k++) {
+			const void *src[2];
+			int stp[2], incr[2];
+			void *dst;
+			int j, a;
+
+			for (j = 0; j < 2; j++) {
+				a = j == 0 ? steps[k].lft : steps[k].rgt;
+				if (j == 1 && steps[k].op == 'c')
+					break;
+				if (a >= nargs) {
+					src[j] = vec[a - nargs];
+					stp[j] = steps[a - nargs].tp;
+					incr[j] = 1;
+				} else if (b[a]) {
+					src[j] = (const char *) Tloc(b[a], 0) + off * b[a]->twidth;
+					stp[j] = b[a]->ttype;
+					incr[j] = 1;
+				} else {
+					src[j] = VALptr(&v[a]);
+					stp[j] = v[a].vtype;
+					incr[j] = 0;
+				}
+			}
+			dst = k == nsteps - 1 ? Tloc(bn, off) : vec[k];
+			switch (steps[k].op) {
+			case '+':
+				r = add_typeswitchloop(src[0], stp[0], incr[0],
+						       src[1], stp[1], incr[1],
+						       dst, steps[k].tp, n,
+						       &(struct canditer){.tpe=cand_dense, .ncand=n},
+						       0, abort_on_error, __func__);
+				break;
+			case '-':
+				r = sub_typeswitchloop(src[0], stp[0], incr[0],
+						       src[1], stp[1], incr[1],
+						       dst, steps[k].tp, n,
+						       &(struct canditer){.tpe=cand_dense, .ncand=n},
+						       0, abort_on_error, __func__);
+				break;
+			case '*':
+				r = mul_typeswitchloop(src[0], stp[0], incr[0],
+						       src[1], stp[1], incr[1],
+						       dst, steps[k].tp, n,
+						       &(struct canditer){.tpe=cand_dense, .ncand=n},
+						       0, abort_on_error, __func__);
+				break;
+			case '/':
+				r = div_typeswitchloop(src[0], stp[0], incr[0],
+						       src[1], stp[1], incr[1],
+						       dst, steps[k].tp, n,
+						       &(struct canditer){.tpe=cand_dense, .ncand=n},
+						       0, abort_on_error, __func__);
+				break;
+			case '%':
+				r = mod_typeswitchloop(src[0], stp[0], incr[0],
+						       src[1], stp[1], incr[1],
+						       dst, steps[k].tp, n,
+						       &(struct canditer){.tpe=cand_dense, .ncand=n},
+						       0, abort_on_error, __func__);
+				break;
+			case 'c': {
+				bool reduce = false;
+
+				if (incr[0] == 0) {
+					GDKerror("%s: cannot convert a constant.\n", __func__);
+					goto bailout;
+				}
+				r = convert_typeswitchloop(src[0], stp[0],
+							   dst, steps[k].tp, n,
+							   &(struct canditer){.tpe=cand_dense, .ncand=n},
+							   0, abort_on_error, &reduce);
+				if (r == BUN_NONE + 1)
+					GDKerror("%s: type combination (convert(%s)->%s) "
+						 "not supported.\n", __func__,
+						 ATOMname(stp[0]), ATOMname(steps[k].tp));
+				break;
+			}
+			default:
+				GDKerror("%s: unknown operator '%c'.\n", __func__,
+					 steps[k].op);
+				goto bailout;
+			}
+			if (r >= BUN_NONE)
+				goto bailout;
+			if (k == nsteps - 1)
+				nils += r;
+		}
+	}
+
+	for (k = 0; k < nsteps; k++)
+		GDKfree(vec[k]);
+	GDKfree(vec);
+
+	BATsetcount(bn, cnt);
+
+	bn->tsorted = cnt <= 1 || nils == cnt;
+	bn->trevsorted = cnt <= 1 || nils == cnt;
+	bn->tkey = cnt <= 1;
+	bn->tnil = nils != 0;
+	bn->tnonil = nils == 0;
+
+	return bn;
+
+  bailout:
+	for (k = 0; k < nsteps; k++)
+		GDKfree(vec[k]);
+	GDKfree(vec);
+	BBPunfix(bn->batCacheid);
+	return NULL;
+}
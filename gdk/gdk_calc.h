@@ -118,6 +118,17 @@ gdk_export gdk_return VARcalcne(ValPtr ret, const ValRecord *lft, const ValRecor
 gdk_export gdk_return VARcalccmp(ValPtr ret, const ValRecord *lft, const ValRecord *rgt);
 gdk_export BAT *BATconvert(BAT *b, BAT *s, int tp, bool abort_on_error);
 gdk_export gdk_return VARconvert(ValPtr ret, const ValRecord *v, bool abort_on_error);
+
+/* one step of a fused calculation (see BATcalcfused); operands with
+ * an index below nargs refer to the arguments, the others to the
+ * result of step (index - nargs) */
+typedef struct {
+	char op;		/* '+', '-', '*', '/', '%', or 'c' (convert) */
+	int tp;			/* result type of the step */
+	int lft, rgt;		/* operands (rgt unused for 'c') */
+} calcstep;
+
+gdk_export BAT *BATcalcfused(BAT **b, const ValRecord *v, int nargs, const calcstep *steps, int nsteps, bool abort_on_error);
 gdk_export gdk_return BATcalcavg(BAT *b, BAT *s, dbl *avg, BUN *vals, int scale);
 
 gdk_export BAT *BATgroupsum(BAT *b, BAT *g, BAT *e, BAT *s, int tp, bool skip_nils, bool abort_on_error);
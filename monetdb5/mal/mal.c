@@ -38,6 +38,7 @@ int have_hge;
 #include "mal_private.h"
 #include "mal_runtime.h"
 #include "mal_resource.h"
+#include "mal_recycle.h"
 #include "wlc.h"
 #include "mal_atom.h"
 #include "opt_pipes.h"
@@ -123,6 +124,7 @@ void mserver_reset(void)
   	mal_linker_reset();
 	mal_resource_reset();
 	mal_runtime_reset();
+	RECYCLEreset();
 	mal_module_reset();
 	mal_atom_reset();
 	opt_pipes_reset();
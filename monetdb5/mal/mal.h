@@ -197,6 +197,7 @@ typedef struct {
 	bte gc;						/* garbage control flags */
 	bit polymorphic;			/* complex type analysis */
 	bit varargs;				/* variable number of arguments */
+	bit recycle;				/* recycler property, see mal_recycle.h */
 	int jump;					/* controlflow program counter */
 	int pc;						/* location in MAL plan for profiler*/
 	MALfcn fcn;					/* resolved function address */
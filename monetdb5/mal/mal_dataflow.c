@@ -31,6 +31,17 @@
 #include "mal_runtime.h"
 #include "mal_resource.h"
 
+/*
+ * The number of partitions chosen by mitosis is based on the size of the
+ * tables only.  After a selective filter many of the partitions carry
+ * only a few tuples, for which the scheduling overhead outweighs the
+ * work itself.  A worker that produced such a tiny result therefore
+ * claims all instructions that were only waiting for it, and handles them
+ * in a row, instead of distributing them over the other workers.
+ */
+#define DFLOWtiny	1024	/* results considered tiny */
+#define DFLOWchain	32	/* instructions a worker may claim in a row */
+
 #define DFLOWpending 0		/* runnable */
 #define DFLOWrunning 1		/* currently in progress */
 #define DFLOWwrapup  2		/* done! */
@@ -319,16 +330,37 @@ q_dequeue(Queue *q, Client cntxt)
  * with this property. Nor do we maintain such properties.
  */
 
+/* the results of an instruction are cheap to consume */
+static bool
+DFLOWtinyresult(DataFlow flow, InstrPtr p)
+{
+	int i;
+	BAT *b;
+
+	for (i = 0; i < p->retc; i++) {
+		ValPtr v = &flow->stk->stk[getArg(p, i)];
+
+		if (v->vtype != TYPE_bat || is_bat_nil(v->val.bval))
+			continue;
+		if ((b = BBPquickdesc(v->val.bval, false)) == NULL || BATcount(b) > DFLOWtiny)
+			return false;
+	}
+	return true;
+}
+
 static void
 DFLOWworker(void *T)
 {
 	struct worker *t = (struct worker *) T;
 	DataFlow flow;
 	FlowEvent fe = 0, fnxt = 0;
+	FlowEvent chain[DFLOWchain];	/* instructions claimed in a row */
+	int nchain = 0;
 	int id = (int) (t - workers);
 	int tid = THRgettid();
 	str error = 0;
 	int i,last;
+	bool tiny;
 	Client cntxt;
 	InstrPtr p;
 
@@ -346,6 +378,8 @@ DFLOWworker(void *T)
 		MT_sema_down(&t->s);
 	}
 	while (1) {
+		if (fnxt == 0 && nchain > 0)
+			fnxt = chain[--nchain];
 		if (fnxt == 0) {
 			MT_thread_setworking(NULL);
 			cntxt = ATOMIC_PTR_GET(&t->cntxt);
@@ -443,19 +477,26 @@ DFLOWworker(void *T)
 		}
 	}
 #endif
+		tiny = DFLOWtinyresult(flow, p);
 		MT_lock_set(&flow->flowlock);
 
 		for (last = fe->pc - flow->start; last >= 0 && (i = flow->nodes[last]) > 0; last = flow->edges[last])
 			if (flow->status[i].state == DFLOWpending &&
 				flow->status[i].blocks == 1) {
+				if (fnxt && (!tiny || nchain == DFLOWchain))
+					break;
 				flow->status[i].state = DFLOWrunning;
 				flow->status[i].blocks = 0;
 				flow->status[i].hotclaim = fe->hotclaim;
 				flow->status[i].argclaim += fe->hotclaim;
 				if( flow->status[i].maxclaim < fe->maxclaim)
 					flow->status[i].maxclaim = fe->maxclaim;
-				fnxt = flow->status + i;
-				break;
+				if (fnxt == 0) {
+					fnxt = flow->status + i;
+				} else {
+					PARDEBUG fprintf(stderr, "#claimed pc= %d after tiny result of pc= %d wrk= %d\n", flow->status[i].pc, fe->pc, id);
+					chain[nchain++] = flow->status + i;
+				}
 			}
 		MT_lock_unset(&flow->flowlock);
 
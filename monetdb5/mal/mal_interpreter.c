@@ -14,6 +14,7 @@
 #include "mal_runtime.h"
 #include "mal_interpreter.h"
 #include "mal_resource.h"
+#include "mal_recycle.h"
 #include "mal_listing.h"
 #include "mal_debugger.h"   /* for mdbStep() */
 #include "mal_type.h"
@@ -465,6 +466,7 @@ str runMALsequence(Client cntxt, MalBlkPtr mb, int startpc,
 	RuntimeProfileRecord runtimeProfile, runtimeProfileFunction;
 	lng lastcheck = 0;
 	int	startedProfileQueue = 0;
+	bool recycled = false;
 #define CHECKINTERVAL 1000 /* how often do we check for client disconnect */
 	runtimeProfile.ticks = runtimeProfileFunction.ticks = 0;
 
@@ -596,7 +598,10 @@ str runMALsequence(Client cntxt, MalBlkPtr mb, int startpc,
 
 		freeException(ret);
 		ret = MAL_SUCCEED;
-		switch (pci->token) {
+		recycled = false;
+		if (pci->recycle && RECYCLEentry(cntxt, mb, stk, pci))
+			recycled = true;	/* the results are taken from the pool */
+		else switch (pci->token) {
 		case ASSIGNsymbol:
 			/* Assignment command
 			 * The assignment statement copies values around on
@@ -805,6 +810,8 @@ str runMALsequence(Client cntxt, MalBlkPtr mb, int startpc,
 		/* this hack means we loose a closing event */
 		if( mb->stop <= 1)
 			continue;
+		if (pci->recycle && !recycled && ret == MAL_SUCCEED)
+			RECYCLEexit(cntxt, mb, stk, pci, GDKusec() - runtimeProfile.ticks);
 		runtimeProfileExit(cntxt, mb, stk, pci, &runtimeProfile);
 		/* check for strong debugging after each MAL statement */
 		/* when we find a timeout situation, then the result is already known 
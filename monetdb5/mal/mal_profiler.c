@@ -525,6 +525,188 @@ profilerHeartbeatEvent(char *alter)
 	logjsonInternal(logbuffer);
 }
 
+/* The JSON rendering above is too expensive to be left on permanently.
+ * In the compact mode the instructions only record a fixed size event in
+ * a ring buffer owned by the thread executing them. The heartbeat thread
+ * drains the rings and renders the events on the profiler stream.
+ * There is only one producer and one consumer per ring, which means no
+ * locks are needed. When a ring is full, events are dropped and reported.
+ * The module and function names are kept in the MAL namespace,
+ * which means they can be referenced safely after the instruction ended.
+ */
+#define PROFILERING 4096	/* events buffered per thread */
+
+typedef struct {
+	const char *modname, *fcnname;	/* the MAL function executed */
+	const char *instrmod, *instrfcn;	/* the instruction executed */
+	lng clk;		/* start or end of the instruction */
+	lng usec;		/* execution time */
+	lng wait;		/* thread idle before the instruction started */
+	lng bytes;		/* size of the BAT results */
+	BUN rowsin, rowsout;
+	oid user, tag;
+	int pc, thread;
+	bool start;
+} ProfileEventRecord;
+
+typedef struct {
+	ATOMIC_TYPE head, tail;	/* produced and consumed events */
+	lng idle;			/* end of the last instruction of this thread */
+	ProfileEventRecord event[PROFILERING];
+} *ProfileRing;
+
+static ProfileRing profilerings[THREADS];
+static int profilesample;	/* one out of N queries in compact mode, 0 for JSON */
+static ATOMIC_TYPE profiledropped = ATOMIC_VAR_INIT(0);
+
+static BUN
+profileRows(MalStkPtr stk, InstrPtr pci, int first, int last, lng *bytes)
+{
+	BUN cnt = 0;
+	BAT *b;
+	int i;
+
+	for (i = first; i < last; i++) {
+		ValPtr v = &stk->stk[getArg(pci, i)];
+
+		if (v->vtype != TYPE_bat || is_bat_nil(v->val.bval) ||
+			(b = BBPquickdesc(v->val.bval, false)) == NULL)
+			continue;
+		cnt += BATcount(b);
+		if (bytes)
+			*bytes += (lng) BATcount(b) * b->twidth + (b->tvheap ? (lng) b->tvheap->free : 0);
+	}
+	return cnt;
+}
+
+static void
+compactProfilerEvent(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci, int start)
+{
+	int tid = THRgettid();
+	ProfileRing r;
+	ProfileEventRecord *e;
+	ATOMIC_BASE_TYPE head;
+
+	if (tid >= THREADS || stk->tag % profilesample != 0)
+		return;
+	if (malprofileruser != MAL_ADMIN && malprofileruser != cntxt->user)
+		return;
+	if ((r = profilerings[tid]) == NULL) {
+		if ((r = GDKmalloc(sizeof(*r))) == NULL)
+			return;
+		ATOMIC_INIT(&r->head, 0);
+		ATOMIC_INIT(&r->tail, 0);
+		r->idle = pci->clock;
+		MT_lock_set(&mal_profileLock);
+		profilerings[tid] = r;
+		MT_lock_unset(&mal_profileLock);
+	}
+	head = ATOMIC_GET(&r->head);
+	if (head - ATOMIC_GET(&r->tail) >= PROFILERING) {
+		(void) ATOMIC_INC(&profiledropped);
+		return;
+	}
+	e = &r->event[head % PROFILERING];
+	e->modname = getModuleId(getInstrPtr(mb, 0));
+	e->fcnname = getFunctionId(getInstrPtr(mb, 0));
+	e->instrmod = pci->modname;
+	e->instrfcn = pci->fcnname;
+	e->user = cntxt->user;
+	e->tag = stk->tag;
+	e->pc = getPC(mb, pci);
+	e->thread = tid;
+	e->start = start != 0;
+	e->bytes = 0;
+	e->rowsin = profileRows(stk, pci, pci->retc, pci->argc, NULL);
+	if (start) {
+		e->clk = pci->clock;
+		e->usec = pci->calls ? pci->totticks / pci->calls : 0;
+		e->wait = pci->clock > r->idle ? pci->clock - r->idle : 0;
+		e->rowsout = 0;
+	} else {
+		e->clk = r->idle = pci->clock + pci->ticks;
+		e->usec = pci->ticks;
+		e->wait = 0;
+		e->rowsout = profileRows(stk, pci, 0, pci->retc, &e->bytes);
+	}
+	ATOMIC_SET(&r->head, head + 1);
+}
+
+/* Render the compact events on the profiler stream, or discard them when
+ * the stream was closed in the mean time. */
+static void
+drainProfiler(void)
+{
+	char logbuffer[LOGLEN], *logbase, event[LOGLEN];
+	size_t loglen;
+	int len;
+	ATOMIC_BASE_TYPE head, tail, dropped;
+	ProfileEventRecord *e;
+	ProfileRing r;
+	int t;
+
+#define logflush()														\
+	do {																\
+		if (maleventstream && loglen > 0) {								\
+			(void) mnstr_write(maleventstream, logbuffer, 1, loglen);	\
+			(void) mnstr_flush(maleventstream);							\
+		}																\
+		lognew();														\
+	} while (0)
+
+	MT_lock_set(&mal_profileLock);
+	lognew();
+	for (t = 0; t < THREADS; t++) {
+		if ((r = profilerings[t]) == NULL)
+			continue;
+		head = ATOMIC_GET(&r->head);
+		for (tail = ATOMIC_GET(&r->tail); tail < head; tail++) {
+			e = &r->event[tail % PROFILERING];
+			if (maleventstream == NULL)
+				continue;
+			len = snprintf(event, LOGLEN,
+							   "{"PRETTIFY"\"source\":\"compact\","PRETTIFY
+							   "\"user_id\":"OIDFMT","PRETTIFY
+							   "\"clk\":"LLFMT","PRETTIFY
+							   "\"thread\":%d,"PRETTIFY
+							   "\"function\":\"%s.%s\","PRETTIFY
+							   "\"pc\":%d,"PRETTIFY
+							   "\"tag\":"OIDFMT","PRETTIFY
+							   "\"module\":\"%s\","PRETTIFY
+							   "\"instruction\":\"%s\","PRETTIFY
+							   "\"state\":\"%s\","PRETTIFY
+							   "\"usec\":"LLFMT","PRETTIFY
+							   "\"wait\":"LLFMT","PRETTIFY
+							   "\"rowsin\":"BUNFMT","PRETTIFY
+							   "\"rowsout\":"BUNFMT","PRETTIFY
+							   "\"bytes\":"LLFMT PRETTIFY
+							   "}\n",
+							   e->user, e->clk, e->thread,
+							   e->modname, e->fcnname, e->pc, e->tag,
+							   e->instrmod ? e->instrmod : "",
+							   e->instrfcn ? e->instrfcn : "",
+							   e->start ? "start" : "done",
+							   e->usec, e->wait, e->rowsin, e->rowsout, e->bytes);
+			if (len < 0 || len >= LOGLEN)
+				continue;
+			if (loglen + len >= LOGLEN)
+				logflush();
+			memcpy(logbase + loglen, event, len + 1);
+			loglen += len;
+		}
+		ATOMIC_SET(&r->tail, head);
+	}
+	if (loglen > LOGLEN - 128)
+		logflush();
+	if ((dropped = ATOMIC_XCG(&profiledropped, 0)) > 0 && maleventstream)
+		loglen += snprintf(logbase + loglen, LOGLEN - loglen,
+						   "{"PRETTIFY"\"source\":\"compact\","PRETTIFY
+						   "\"dropped\":%zu"PRETTIFY"}\n", (size_t) dropped);
+	logflush();
+	MT_lock_unset(&mal_profileLock);
+#undef logflush
+}
+
 void
 profilerEvent(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci, int start)
 {
@@ -534,7 +716,9 @@ profilerEvent(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci, int start
 	if (getModuleId(pci) == myname) // ignore profiler commands from monitoring
 		return;
 
-	if( maleventstream) {
+	if( maleventstream && profilesample > 0) {
+		compactProfilerEvent(cntxt, mb, stk, pci, start);
+	} else if( maleventstream) {
 		renderProfilerEvent(cntxt, mb, stk, pci, start);
 		if ( !start && pci->pc ==0)
 			profilerHeartbeatEvent("ping");
@@ -544,9 +728,11 @@ profilerEvent(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci, int start
 }
 
 /* The first scheme dumps the events on a stream (and in the pool)
+ * A positive sample rate selects the compact events for one out of
+ * every sample queries.
  */
 str
-openProfilerStream(Client cntxt)
+openProfilerStream(Client cntxt, int sample)
 {
 	int j;
 
@@ -566,6 +752,7 @@ openProfilerStream(Client cntxt)
 			throw(MAL,"profiler.start","Profiler already running, stream not available");
 	}
 	malProfileMode = -1;
+	profilesample = sample > 0 ? sample : 0;
 	maleventstream = cntxt->fdout;
 	malprofileruser = cntxt->user;
 
@@ -589,6 +776,7 @@ closeProfilerStream(Client cntxt)
 	maleventstream = NULL;
 	malProfileMode = 0;
 	malprofileruser = 0;
+	profilesample = 0;
 	return MAL_SUCCEED;
 }
 
@@ -886,11 +1074,13 @@ static void profilerHeartbeat(void *dummy)
 		while (ATOMIC_GET(&hbdelay) == 0 || maleventstream == NULL) {
 			if (GDKexiting() || !ATOMIC_GET(&hbrunning))
 				return;
+			drainProfiler();
 			MT_sleep_ms(timeout);
 		}
 		for (t = (int) ATOMIC_GET(&hbdelay); t > 0; t -= timeout) {
 			if (GDKexiting() || !ATOMIC_GET(&hbrunning))
 				return;
+			drainProfiler();
 			MT_sleep_ms(t > timeout ? timeout : t);
 		}
 		if (GDKexiting() || !ATOMIC_GET(&hbrunning))
@@ -902,10 +1092,16 @@ static void profilerHeartbeat(void *dummy)
 
 void setHeartbeat(int delay)
 {
+	int t;
+
 	if (delay < 0 ){
 		ATOMIC_SET(&hbrunning, 0);
 		if (hbthread)
 			MT_join_thread(hbthread);
+		for (t = 0; t < THREADS; t++) {
+			GDKfree(profilerings[t]);
+			profilerings[t] = NULL;
+		}
 		return;
 	}
 	if ( delay > 0 &&  delay <= 10)
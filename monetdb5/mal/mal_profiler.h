@@ -23,7 +23,7 @@ typedef struct rusage Rusage;
 mal_export int malProfileMode;
 
 mal_export void initProfiler(void);
-mal_export str openProfilerStream(Client cntxt);
+mal_export str openProfilerStream(Client cntxt, int sample);
 mal_export str closeProfilerStream(Client cntxt);
 
 mal_export void profilerEvent(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci, int start);
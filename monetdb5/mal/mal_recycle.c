@@ -0,0 +1,381 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 1997 - July 2008 CWI, August 2008 - 2019 MonetDB B.V.
+ */
+
+/*
+ * The recycler keeps the intermediates produced by instructions marked by
+ * the recycler optimizer in a server wide pool, such that a subsequent
+ * query, or the same query issued again, can reuse them instead of
+ * computing them again.
+ *
+ * An entry is identified by the instruction and the value of its arguments.
+ * The source instructions access persistent data, whose version is
+ * obtained from the front-end, such that updates invalidate them.
+ * All other instructions are only recycled when their BAT arguments are
+ * themselves kept in the pool. An entry also records which entry produced
+ * each of its BAT arguments most recently. This lineage guarantees that
+ * BAT identifiers are never confused with BATs that have been freed and
+ * reused, or persistent BATs that have been changed in the mean time.
+ * Whenever an entry is evicted, all entries depending on it are removed
+ * as well.
+ *
+ * The pool is bounded by the memory taken by the intermediates, which can
+ * be set with the recycle_memory property (MB).
+ * Entries are evicted based on their benefit, i.e. the time saved per byte.
+ * The derived intermediates are marked read only once they are recycled.
+ */
+#include "monetdb_config.h"
+#include "mal_recycle.h"
+#include "mal_private.h"
+
+#define RECYCLEHASH	1024
+
+typedef struct RECYCLE {
+	struct RECYCLE *next, *prev;	/* the pool, most recently used first */
+	struct RECYCLE *chain;		/* entries with the same hash key */
+	size_t key;
+	MALfcn fcn;
+	str modname, fcnname;
+	lng version;
+	int argc, retc;
+	ValRecord arg[RECYCLEMAXARG];	/* the results, followed by the arguments */
+	struct RECYCLE *lineage[RECYCLEMAXARG];	/* the producers of the BAT arguments */
+	lng cost;					/* time to compute the results */
+	lng size;					/* memory held by the results */
+	lng hits;
+} *Recycle;
+
+RecycleVersion RECYCLEversion = NULL;
+
+static MT_Lock recycleLock = MT_LOCK_INITIALIZER("recycleLock");
+static Recycle recyclepool;
+static Recycle recyclehash[RECYCLEHASH];
+static Recycle *recycleowner;	/* the entry producing a BAT most recently */
+static bat recycleownersize;
+static lng recyclememory, recyclelimit;
+static lng recycleentries, recyclehits, recyclemisses;
+
+static inline Recycle
+RECYCLEowner(bat bid)
+{
+	return bid > 0 && bid < recycleownersize ? recycleowner[bid] : NULL;
+}
+
+/* compute the lookup key, or return false if the instruction can not be
+ * recycled at this point */
+static bool
+RECYCLEkey(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci, lng *version, Recycle *lineage, size_t *key)
+{
+	ValPtr v;
+	int i;
+	size_t k;
+
+	if (pci->argc > RECYCLEMAXARG)
+		return false;
+	*version = 0;
+	if (pci->recycle == RECYCLE_SOURCE &&
+		(RECYCLEversion == NULL || (*version = (*RECYCLEversion)(cntxt, mb, stk, pci)) < 0))
+		return false;
+	k = (size_t) pci->fcn ^ (size_t) *version;
+	for (i = pci->retc; i < pci->argc; i++) {
+		v = &stk->stk[getArg(pci, i)];
+		lineage[i] = NULL;
+		if (v->vtype == TYPE_bat) {
+			if (is_bat_nil(v->val.bval))
+				continue;
+			lineage[i] = RECYCLEowner(v->val.bval);
+			if (pci->recycle != RECYCLE_SOURCE && lineage[i] == NULL)
+				return false;
+			k = (k << 3) ^ (k >> 29) ^ (size_t) v->val.bval;
+		} else if (BATatoms[v->vtype].atomHash)
+			k = (k << 3) ^ (k >> 29) ^ (size_t) ATOMhash(v->vtype, VALptr(v));
+	}
+	*key = k;
+	return true;
+}
+
+static Recycle
+RECYCLEfind(InstrPtr pci, MalStkPtr stk, lng version, Recycle *lineage, size_t key)
+{
+	Recycle e;
+	ValPtr v;
+	int i;
+
+	for (e = recyclehash[key % RECYCLEHASH]; e; e = e->chain) {
+		if (e->key != key || e->fcn != pci->fcn || e->version != version ||
+			e->argc != pci->argc || e->retc != pci->retc ||
+			e->modname != pci->modname || e->fcnname != pci->fcnname)
+			continue;
+		for (i = pci->retc; i < pci->argc; i++) {
+			v = &stk->stk[getArg(pci, i)];
+			if (v->vtype != e->arg[i].vtype)
+				break;
+			if (v->vtype == TYPE_bat) {
+				if (v->val.bval != e->arg[i].val.bval || lineage[i] != e->lineage[i])
+					break;
+			} else if (ATOMcmp(v->vtype, VALptr(v), VALptr(&e->arg[i])) != 0)
+				break;
+		}
+		if (i == pci->argc)
+			return e;
+	}
+	return NULL;
+}
+
+static void
+RECYCLEunlink(Recycle e)
+{
+	Recycle *h;
+
+	if (e->prev)
+		e->prev->next = e->next;
+	else
+		recyclepool = e->next;
+	if (e->next)
+		e->next->prev = e->prev;
+	e->next = e->prev = NULL;
+	for (h = &recyclehash[e->key % RECYCLEHASH]; *h; h = &(*h)->chain)
+		if (*h == e) {
+			*h = e->chain;
+			break;
+		}
+}
+
+static void
+RECYCLEpush(Recycle e)
+{
+	e->prev = NULL;
+	e->next = recyclepool;
+	if (recyclepool)
+		recyclepool->prev = e;
+	recyclepool = e;
+}
+
+/* remove an entry and everything derived from it */
+static void
+RECYCLEevict(Recycle e)
+{
+	Recycle d;
+	int i, j;
+	bool used;
+
+	RECYCLEunlink(e);
+	for (i = 0; i < e->retc; i++)
+		if (e->arg[i].vtype == TYPE_bat && RECYCLEowner(e->arg[i].val.bval) == e)
+			recycleowner[e->arg[i].val.bval] = NULL;
+	do {
+		used = false;
+		for (d = recyclepool; d && !used; d = d->next)
+			for (j = d->retc; j < d->argc && !used; j++)
+				if (d->lineage[j] == e) {
+					RECYCLEevict(d);
+					used = true;
+				}
+	} while (used);
+	for (i = 0; i < e->retc; i++)
+		if (e->arg[i].vtype == TYPE_bat && !is_bat_nil(e->arg[i].val.bval))
+			BBPrelease(e->arg[i].val.bval);
+	for (i = 0; i < e->argc; i++)
+		if (e->arg[i].vtype != TYPE_bat)
+			VALclear(&e->arg[i]);
+	recyclememory -= e->size;
+	recycleentries--;
+	GDKfree(e);
+}
+
+/* the entry with the least time saved per byte */
+static Recycle
+RECYCLEvictim(void)
+{
+	Recycle e, v = NULL;
+	dbl b, vb = 0;
+
+	for (e = recyclepool; e; e = e->next) {
+		b = (dbl) e->cost * (e->hits + 1) / (e->size + 1);
+		if (v == NULL || b <= vb) {
+			v = e;
+			vb = b;
+		}
+	}
+	return v;
+}
+
+bool
+RECYCLEentry(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	Recycle e, lineage[RECYCLEMAXARG];
+	ValPtr lhs;
+	lng version;
+	size_t key;
+	int i;
+
+	MT_lock_set(&recycleLock);
+	if (!RECYCLEkey(cntxt, mb, stk, pci, &version, lineage, &key) ||
+		(e = RECYCLEfind(pci, stk, version, lineage, key)) == NULL) {
+		recyclemisses++;
+		MT_lock_unset(&recycleLock);
+		return false;
+	}
+	for (i = 0; i < pci->retc; i++) {
+		lhs = &stk->stk[getArg(pci, i)];
+		if (VALcopy(lhs, &e->arg[i]) == NULL) {
+			/* let the instruction be executed instead */
+			while (--i >= 0) {
+				lhs = &stk->stk[getArg(pci, i)];
+				if (lhs->vtype == TYPE_bat)
+					BBPrelease(lhs->val.bval);
+				else
+					VALclear(lhs);
+			}
+			MT_lock_unset(&recycleLock);
+			return false;
+		}
+		if (lhs->vtype == TYPE_bat && !is_bat_nil(lhs->val.bval))
+			BBPretain(lhs->val.bval);
+	}
+	for (i = 0; i < pci->retc; i++)
+		if (e->arg[i].vtype == TYPE_bat && !is_bat_nil(e->arg[i].val.bval))
+			recycleowner[e->arg[i].val.bval] = e;
+	e->hits++;
+	recyclehits++;
+	RECYCLEunlink(e);
+	RECYCLEpush(e);
+	e->chain = recyclehash[key % RECYCLEHASH];
+	recyclehash[key % RECYCLEHASH] = e;
+	MT_lock_unset(&recycleLock);
+	return true;
+}
+
+void
+RECYCLEexit(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci, lng ticks)
+{
+	Recycle e, lineage[RECYCLEMAXARG];
+	ValPtr v;
+	BAT *b;
+	lng version, size = 0;
+	size_t key;
+	int i, j;
+
+	MT_lock_set(&recycleLock);
+	if (recyclelimit == 0) {
+		recyclelimit = (lng) GDKgetenv_int("recycle_memory", 0) * 1024 * 1024;
+		if (recyclelimit <= 0)
+			recyclelimit = (lng) monet_memory / 16;
+	}
+	if (!RECYCLEkey(cntxt, mb, stk, pci, &version, lineage, &key) ||
+		RECYCLEfind(pci, stk, version, lineage, key) != NULL)
+		goto wrapup;
+	for (i = 0; i < pci->retc; i++) {
+		v = &stk->stk[getArg(pci, i)];
+		if (v->vtype != TYPE_bat || is_bat_nil(v->val.bval))
+			continue;
+		/* results passed through can not be administered */
+		for (j = pci->retc; j < pci->argc; j++)
+			if (stk->stk[getArg(pci, j)].vtype == TYPE_bat &&
+				stk->stk[getArg(pci, j)].val.bval == v->val.bval)
+				goto wrapup;
+		if ((b = BBPquickdesc(v->val.bval, false)) == NULL)
+			goto wrapup;
+		size += (lng) BATcount(b) * b->twidth;
+		if (!isVIEW(b) && b->tvheap)
+			size += (lng) b->tvheap->free;
+	}
+	if (size > recyclelimit / 2)
+		goto wrapup;
+
+	while (recyclepool && recyclememory + size > recyclelimit)
+		RECYCLEevict(RECYCLEvictim());
+	/* evictions may have removed the lineage of the arguments */
+	if (!RECYCLEkey(cntxt, mb, stk, pci, &version, lineage, &key))
+		goto wrapup;
+
+	if (recycleownersize < getBBPsize()) {
+		bat sz = getBBPsize() + 1024;
+		Recycle *o = GDKrealloc(recycleowner, sz * sizeof(Recycle));
+
+		if (o == NULL)
+			goto wrapup;
+		memset(o + recycleownersize, 0, (sz - recycleownersize) * sizeof(Recycle));
+		recycleowner = o;
+		recycleownersize = sz;
+	}
+	if ((e = GDKzalloc(sizeof(*e))) == NULL)
+		goto wrapup;
+	e->key = key;
+	e->fcn = pci->fcn;
+	e->modname = pci->modname;
+	e->fcnname = pci->fcnname;
+	e->version = version;
+	e->argc = pci->argc;
+	e->retc = pci->retc;
+	e->cost = ticks;
+	e->size = size;
+	for (i = 0; i < pci->argc; i++) {
+		v = &stk->stk[getArg(pci, i)];
+		if (i >= pci->retc)
+			e->lineage[i] = lineage[i];
+		if (v->vtype == TYPE_bat) {
+			e->arg[i] = *v;
+			continue;
+		}
+		if (VALcopy(&e->arg[i], v) == NULL) {
+			while (--i >= 0)
+				if (e->arg[i].vtype != TYPE_bat)
+					VALclear(&e->arg[i]);
+			GDKfree(e);
+			goto wrapup;
+		}
+	}
+	for (i = 0; i < pci->retc; i++) {
+		v = &e->arg[i];
+		if (v->vtype != TYPE_bat || is_bat_nil(v->val.bval))
+			continue;
+		BBPretain(v->val.bval);
+		recycleowner[v->val.bval] = e;
+		/* shared intermediates should not be changed, the BATs
+		 * returned by the sources remain owned by the front-end */
+		if (pci->recycle == RECYCLE_DERIVED &&
+			(b = BATdescriptor(v->val.bval)) != NULL) {
+			if (b->batRestricted == BAT_WRITE && b->batRole == TRANSIENT)
+				(void) BATsetaccess(b, BAT_READ);
+			BBPunfix(b->batCacheid);
+		}
+	}
+	RECYCLEpush(e);
+	e->chain = recyclehash[key % RECYCLEHASH];
+	recyclehash[key % RECYCLEHASH] = e;
+	recyclememory += size;
+	recycleentries++;
+  wrapup:
+	MT_lock_unset(&recycleLock);
+}
+
+void
+RECYCLEreset(void)
+{
+	MT_lock_set(&recycleLock);
+	while (recyclepool)
+		RECYCLEevict(recyclepool);
+	GDKfree(recycleowner);
+	recycleowner = NULL;
+	recycleownersize = 0;
+	recyclememory = 0;
+	recyclelimit = 0;
+	recyclehits = recyclemisses = 0;
+	MT_lock_unset(&recycleLock);
+}
+
+void
+RECYCLEstatistics(lng *entries, lng *memory, lng *hits, lng *misses)
+{
+	MT_lock_set(&recycleLock);
+	*entries = recycleentries;
+	*memory = recyclememory;
+	*hits = recyclehits;
+	*misses = recyclemisses;
+	MT_lock_unset(&recycleLock);
+}
@@ -0,0 +1,32 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 1997 - July 2008 CWI, August 2008 - 2019 MonetDB B.V.
+ */
+
+#ifndef _MAL_RECYCLE_H
+#define _MAL_RECYCLE_H
+
+#include "mal_interpreter.h"
+
+/* The recycle property of an instruction, set by the recycler optimizer */
+#define RECYCLE_NONE	0
+#define RECYCLE_DERIVED	1	/* BAT arguments should come from the recycle pool */
+#define RECYCLE_SOURCE	2	/* access to persistent data, see RECYCLEversion */
+
+#define RECYCLEMAXARG	16	/* instructions with more arguments are ignored */
+
+/* The version of the data accessed by a source instruction, or a negative
+ * number if its result may not be shared with other queries.
+ * It is provided by the front-end owning the persistent data. */
+typedef lng (*RecycleVersion)(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
+mal_export RecycleVersion RECYCLEversion;
+
+mal_export bool RECYCLEentry(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
+mal_export void RECYCLEexit(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci, lng ticks);
+mal_export void RECYCLEreset(void);
+mal_export void RECYCLEstatistics(lng *entries, lng *memory, lng *hits, lng *misses);
+
+#endif /* _MAL_RECYCLE_H */
@@ -704,4 +704,8 @@ pattern ifthenelse(b:bat[:bit], b1:bat[:any_1], b2:bat[:any_1]) :bat[:any_1]
 address CMDifthen
 comment "If-then-else operation to assemble a conditional result";
 
+pattern fused(prog:str, a:any...) :bat[:any]
+address CMDbatFUSED
+comment "Evaluate a fused tree of arithmetic operations and conversions in a single pass";
+
 EOF
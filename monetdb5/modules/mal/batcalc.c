@@ -1357,3 +1357,131 @@ CMDifthen(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 	BBPkeepref(*ret = bn->batCacheid);
 	return MAL_SUCCEED;
 }
+
+/*
+ * A fused calculation evaluates a tree of batcalc operations in a
+ * single call.  The program is a semicolon separated list of steps of
+ * the form "tpe:op(x,y)" for arithmetic and "tpe:tpe(x)" for type
+ * conversion, where tpe is the result type of the step and the
+ * operands x and y are either An (the n-th argument following the
+ * program) or Rn (the result of the n-th step).  The last step
+ * produces the result.  Such calls are generated by the JIT optimizer.
+ */
+static const char *
+fusedoperand(const char *s, int nargs, int nsteps, int *opnd)
+{
+	char *e;
+	long n;
+
+	if (*s != 'A' && *s != 'R')
+		return NULL;
+	n = strtol(s + 1, &e, 10);
+	if (e == s + 1 || n < 0)
+		return NULL;
+	if (*s == 'A') {
+		if (n >= nargs)
+			return NULL;
+		*opnd = (int) n;
+	} else {
+		if (n >= nsteps)
+			return NULL;
+		*opnd = nargs + (int) n;
+	}
+	return e;
+}
+
+mal_export str CMDbatFUSED(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
+
+str
+CMDbatFUSED(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	const char *prog = *getArgReference_str(stk, pci, 1), *s;
+	int nargs = pci->argc - 2, nsteps = 1, i, tp;
+	BAT **b = NULL, *bn = NULL;
+	calcstep *steps = NULL;
+	ValRecord *v = NULL;
+	str msg = MAL_SUCCEED;
+	char name[IDLENGTH];
+	size_t len;
+	bat *bid;
+
+	(void) cntxt;
+
+	for (s = prog; *s; s++)
+		nsteps += *s == ';';
+	b = GDKzalloc(nargs * sizeof(BAT *));
+	v = GDKzalloc(nargs * sizeof(ValRecord));
+	steps = GDKzalloc(nsteps * sizeof(calcstep));
+	if (b == NULL || v == NULL || steps == NULL) {
+		msg = createException(MAL, "batcalc.fused", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+		goto bailout;
+	}
+
+	for (i = 0, s = prog; i < nsteps; i++) {
+		len = strcspn(s, ":");
+		if (s[len] != ':' || len >= sizeof(name))
+			goto illegal;
+		snprintf(name, sizeof(name), "%.*s", (int) len, s);
+		if ((steps[i].tp = getAtomIndex(name, len, -1)) < 0)
+			goto illegal;
+		s += len + 1;
+		len = strcspn(s, "(");
+		if (s[len] != '(')
+			goto illegal;
+		if (len == 1 && strchr("+-*/%", *s) != NULL)
+			steps[i].op = *s;
+		else if (strncmp(s, name, len) == 0 && name[len] == 0)
+			steps[i].op = 'c';
+		else
+			goto illegal;
+		s += len + 1;
+		if ((s = fusedoperand(s, nargs, i, &steps[i].lft)) == NULL)
+			goto illegal;
+		if (steps[i].op != 'c') {
+			if (*s++ != ',' ||
+				(s = fusedoperand(s, nargs, i, &steps[i].rgt)) == NULL)
+				goto illegal;
+		}
+		if (*s++ != ')' || (i < nsteps - 1 ? *s++ != ';' : *s != 0))
+			goto illegal;
+	}
+	tp = getBatType(getArgType(mb, pci, 0));
+	if (steps[nsteps - 1].tp != tp)
+		goto illegal;
+
+	for (i = 0; i < nargs; i++) {
+		tp = stk->stk[getArg(pci, i + 2)].vtype;
+		if (tp == TYPE_bat || isaBatType(tp)) {
+			bid = getArgReference_bat(stk, pci, i + 2);
+			if ((b[i] = BATdescriptor(*bid)) == NULL) {
+				msg = createException(MAL, "batcalc.fused", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+				goto bailout;
+			}
+		} else {
+			v[i] = stk->stk[getArg(pci, i + 2)];
+		}
+	}
+
+	bn = BATcalcfused(b, v, nargs, steps, nsteps, true);
+	if (bn == NULL) {
+		msg = mythrow(MAL, "batcalc.fused", OPERATION_FAILED);
+		goto bailout;
+	}
+	bid = getArgReference_bat(stk, pci, 0);
+	BBPkeepref(*bid = bn->batCacheid);
+
+  bailout:
+	if (b) {
+		for (i = 0; i < nargs; i++)
+			if (b[i])
+				BBPunfix(b[i]->batCacheid);
+		GDKfree(b);
+	}
+	GDKfree(v);
+	GDKfree(steps);
+	return msg;
+
+  illegal:
+	msg = createException(MAL, "batcalc.fused", SQLSTATE(42000) ILLEGAL_ARGUMENT " Illegal program '%s'", prog);
+	goto bailout;
+}
@@ -38,11 +38,12 @@
 str
 CMDopenProfilerStream(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pc)
 {
-	(void) cntxt;
+	int sample = 0;
+
 	(void) mb;
-	(void) stk;
-	(void) pc;
-	return openProfilerStream(cntxt);
+	if (pc->argc > 1)
+		sample = *getArgReference_int(stk, pc, 1);
+	return openProfilerStream(cntxt, sample);
 }
 
 str
@@ -7,89 +7,265 @@
  */
 
 /* author M.Kersten
- * This optimizer can be used for JIT optimization and moves
- * candidate lists into MAL operations where possible.
+ * The JIT optimizer fuses trees of batcalc arithmetic and type
+ * conversions into a single batcalc.fused call.
  * It should be ran after the candidates optimizer.
- * Specific snippets to be replaced
- *     C_1:bat[:oid] := sql.tid(X_0,"sys","t");
- *     X_4:bat[:int] := sql.bind(X_0,"sys","t","i",0);
- *     X_13 := algebra.projection(C_1,X_4);
- * projection can be avoided
+ * A typical snippet is
+ *     X_38:bat[:lng] := batcalc.-(100:lng, X_27:bat[:lng]);
+ *     X_41:bat[:hge] := batcalc.*(X_20:bat[:lng], X_38:bat[:lng]);
+ *     X_45:bat[:lng] := batcalc.+(X_34:bat[:lng], 100:lng);
+ *     X_47:bat[:hge] := batcalc.*(X_41:bat[:hge], X_45:bat[:lng]);
+ * which becomes
+ *     X_47:bat[:hge] := batcalc.fused("lng:-(A1,A2);hge:*(A0,R0);lng:+(A3,A1);hge:*(R1,R2)",
+ *                          X_20, 100:lng, X_27, X_34);
+ * The intermediates X_38, X_41 and X_45 are then only kept in vector
+ * sized buffers instead of being materialized as BATs.
  *
- * A candidate list can be pushed into the calculations
+ * Only intermediates that are assigned once and used once, by another
+ * fusable instruction, are absorbed.  Operations with candidate lists
+ * are left alone, because their result keeps the size of the input.
  */
 #include "monetdb_config.h"
 #include "mal_builder.h"
 #include "opt_jit.h"
 
+#define MAXJITSTEPS 128		/* limit the size of a fused tree */
+
+static bool
+OPTjitNumeric(int tp)
+{
+	return tp == TYPE_bte || tp == TYPE_sht || tp == TYPE_int ||
+		tp == TYPE_lng ||
+#ifdef HAVE_HGE
+		tp == TYPE_hge ||
+#endif
+		tp == TYPE_flt || tp == TYPE_dbl;
+}
+
+/* the operator of a fusable instruction (see BATcalcfused), or 0 */
+static char
+OPTjitOperator(MalBlkPtr mb, InstrPtr p)
+{
+	int j, tp;
+	char op;
+
+	if (getModuleId(p) != batcalcRef || p->barrier || p->retc != 1)
+		return 0;
+	tp = getArgType(mb, p, 0);
+	if (!isaBatType(tp) || !OPTjitNumeric(getBatType(tp)))
+		return 0;
+	tp = getBatType(tp);
+	if (p->argc == 3 && getFunctionId(p)[0] && getFunctionId(p)[1] == 0 &&
+		strchr("+-*/%", getFunctionId(p)[0]) != NULL)
+		op = getFunctionId(p)[0];
+	else if (p->argc == 2 && strcmp(getFunctionId(p), ATOMname(tp)) == 0 &&
+			 isaBatType(getArgType(mb, p, 1)))
+		op = 'c';
+	else
+		return 0;
+	for (j = p->retc; j < p->argc; j++) {
+		tp = getArgType(mb, p, j);
+		if (isaBatType(tp))
+			tp = getBatType(tp);
+		if (!OPTjitNumeric(tp))
+			return 0;
+	}
+	return op;
+}
+
+typedef struct {
+	int *args;			/* operands of the fused instruction */
+	int nargs;
+	int nsteps;
+	char prog[MAXJITSTEPS * 64];
+	size_t len;
+} jitfuse;
+
+/* append the steps computing instruction pc to the program and
+ * return the operand that denotes its result */
+static void
+OPTjitTree(MalBlkPtr mb, InstrPtr *old, int *def, char *absorbed, int pc, jitfuse *f, char *opnd, size_t opndlen)
+{
+	InstrPtr p = old[pc];
+	char x[2][16];
+	int j, k, a;
+
+	for (j = p->retc; j < p->argc; j++) {
+		a = getArg(p, j);
+		if (def[a] > 0 && absorbed[def[a] - 1]) {
+			OPTjitTree(mb, old, def, absorbed, def[a] - 1, f, x[j - p->retc], sizeof(x[0]));
+			continue;
+		}
+		for (k = 0; k < f->nargs; k++)
+			if (f->args[k] == a)
+				break;
+		if (k == f->nargs)
+			f->args[f->nargs++] = a;
+		snprintf(x[j - p->retc], sizeof(x[0]), "A%d", k);
+	}
+	f->len += snprintf(f->prog + f->len, sizeof(f->prog) - f->len,
+					   "%s%s:%s(%s%s%s)", f->nsteps ? ";" : "",
+					   ATOMname(getBatType(getArgType(mb, p, 0))),
+					   getFunctionId(p), x[0],
+					   p->argc == 3 ? "," : "", p->argc == 3 ? x[1] : "");
+	snprintf(opnd, opndlen, "R%d", f->nsteps++);
+}
+
 str
 OPTjitImplementation(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 {
-	int i,actions = 0;
-	int limit = mb->stop;
-	InstrPtr p, q, *old = mb->stmt;
+	int i, j, a, actions = 0;
+	int limit = mb->stop, slimit = mb->ssize;
+	InstrPtr p, q, *old = NULL;
+	int *def = NULL, *uses = NULL, *user = NULL, *size = NULL;
+	char *ops = NULL, *absorbed = NULL;
+	jitfuse *f = NULL;
 	char buf[256];
 	lng usec = GDKusec();
 	str msg = MAL_SUCCEED;
 
 	(void) stk;
-	(void) cntxt;
 	(void) pci;
 
-    if( OPTdebug &  OPTjit){
+	if (mb->inlineProp)
+		return MAL_SUCCEED;
+
+	if( OPTdebug &  OPTjit){
 		fprintf(stderr, "#Optimize JIT\n");
 		fprintFunction(stderr, mb, 0, LIST_MAL_ALL);
 	}
 
-	setVariableScope(mb);
-	if ( newMalBlkStmt(mb, mb->ssize) < 0)
-		throw(MAL,"optimizer.jit", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+	def = (int *) GDKzalloc(sizeof(int) * mb->vtop);	/* pc + 1 of the assignment, -1 if many */
+	uses = (int *) GDKzalloc(sizeof(int) * mb->vtop);
+	user = (int *) GDKzalloc(sizeof(int) * mb->vtop);	/* pc of the last use */
+	size = (int *) GDKzalloc(sizeof(int) * limit);	/* steps in the tree */
+	ops = (char *) GDKzalloc(limit);
+	absorbed = (char *) GDKzalloc(limit);
+	f = (jitfuse *) GDKzalloc(sizeof(jitfuse));
+	if (def == NULL || uses == NULL || user == NULL || size == NULL || ops == NULL || absorbed == NULL || f == NULL ||
+		(f->args = (int *) GDKzalloc(sizeof(int) * 2 * MAXJITSTEPS)) == NULL) {
+		msg = createException(MAL, "optimizer.jit", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+		goto wrapup;
+	}
 
-	/* peephole optimization */
 	for (i = 0; i < limit; i++) {
-		p = old[i];
+		p = getInstrPtr(mb, i);
+		for (j = 0; j < p->retc; j++) {
+			a = getArg(p, j);
+			def[a] = def[a] ? -1 : i + 1;
+		}
+		for (j = p->retc; j < p->argc; j++) {
+			a = getArg(p, j);
+			uses[a]++;
+			user[a] = i;
+		}
+		ops[i] = OPTjitOperator(mb, p);
+	}
 
-		if (p->token == ENDsymbol){
-			for(; i<limit; i++)
-				if (old[i])
-					pushInstruction(mb,old[i]);
-			break;
+	/* an intermediate is absorbed into the instruction that consumes it
+	 * if it is the only use, and none of its operands is re-assigned */
+	for (i = 0; i < limit; i++) {
+		if (!ops[i])
+			continue;
+		p = getInstrPtr(mb, i);
+		size[i] = 1;
+		for (j = p->retc; j < p->argc; j++) {
+			a = getArg(p, j);
+			if (def[a] > 0 && absorbed[def[a] - 1])
+				size[i] += size[def[a] - 1];
 		}
-		/* case 1
-		 * X_527 := algebra.projection(C_353, X_329);
-		 * X_535 := batcalc.-(100:lng, X_527); 
-		 */
-		if( getModuleId(p) == batcalcRef && *getFunctionId(p) == '-' && p->argc == 3 && isVarConstant(mb, getArg(p,1)) ){
-			q= getInstrPtr(mb, getVar(mb,getArg(p,2))->updated);
-			if ( q == 0)
-				q= getInstrPtr(mb, getVar(mb,getArg(p,2))->declared);
-			if( q && getArg(q,0) == getArg(p,2) && getModuleId(q) == algebraRef && getFunctionId(q) == projectionRef ){
-				getArg(p,2)=  getArg(q,2);
-				p= pushArgument(mb,p, getArg(q,1));
-				if( OPTdebug &  OPTjit){
-					fprintf(stderr, "#Optimize JIT case 1\n");
-					fprintInstruction(stderr, mb,0,p,LIST_MAL_ALL);
-				}
+		if (size[i] > MAXJITSTEPS) {
+			/* too large, let the operands be fused on their own */
+			for (j = p->retc; j < p->argc; j++) {
+				a = getArg(p, j);
+				if (def[a] > 0)
+					absorbed[def[a] - 1] = 0;
 			}
+			size[i] = 1;
 		}
-		pushInstruction(mb,p);
+		a = getArg(p, 0);
+		if (def[a] != i + 1 || uses[a] != 1 || user[a] <= i || !ops[user[a]])
+			continue;
+		for (j = p->retc; j < p->argc; j++)
+			if (def[getArg(p, j)] < 0)
+				break;
+		if (j == p->argc)
+			absorbed[i] = 1;
 	}
 
-	GDKfree(old);
-    /* Defense line against incorrect plans */
-	chkTypes(cntxt->usermodule, mb, FALSE);
-	chkFlow(mb);
-	chkDeclarations(mb);
-    /* keep all actions taken as a post block comment */
+	old = mb->stmt;
+	if (newMalBlkStmt(mb, mb->ssize) < 0) {
+		old = NULL;
+		msg = createException(MAL, "optimizer.jit", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+		goto wrapup;
+	}
+
+	for (i = 0; i < limit; i++) {
+		p = old[i];
+		if (absorbed[i])
+			continue;
+		if (msg == MAL_SUCCEED && ops[i] && size[i] > 1) {
+			char opnd[16];
+
+			f->nargs = f->nsteps = 0;
+			f->len = 0;
+			OPTjitTree(mb, old, def, absorbed, i, f, opnd, sizeof(opnd));
+			q = newInstruction(mb, batcalcRef, fusedRef);
+			if (q == NULL) {
+				msg = createException(MAL, "optimizer.jit", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+				pushInstruction(mb, p);
+				continue;
+			}
+			getArg(q, 0) = getArg(p, 0);
+			q = pushStr(mb, q, f->prog);
+			for (j = 0; j < f->nargs; j++)
+				q = pushArgument(mb, q, f->args[j]);
+			if( OPTdebug &  OPTjit){
+				fprintf(stderr, "#Optimize JIT fused %d steps\n", size[i]);
+				fprintInstruction(stderr, mb, 0, q, LIST_MAL_ALL);
+			}
+			pushInstruction(mb, q);
+			freeInstruction(p);
+			actions++;
+			continue;
+		}
+		pushInstruction(mb, p);
+	}
+	for (i = 0; i < limit; i++)
+		if (absorbed[i])
+			freeInstruction(old[i]);
+	for (; i < slimit; i++)
+		if (old[i])
+			freeInstruction(old[i]);
+
+	/* Defense line against incorrect plans */
+	if (actions > 0 && msg == MAL_SUCCEED) {
+		chkTypes(cntxt->usermodule, mb, FALSE);
+		chkFlow(mb);
+		chkDeclarations(mb);
+	}
+wrapup:
+	/* keep all actions taken as a post block comment */
 	usec = GDKusec()- usec;
-    snprintf(buf,256,"%-20s actions=%2d time=" LLFMT " usec","jit",actions, usec);
-    newComment(mb,buf);
+	snprintf(buf,256,"%-20s actions=%2d time=" LLFMT " usec","jit",actions, usec);
+	newComment(mb,buf);
 	if( actions >= 0)
 		addtoMalBlkHistory(mb);
+	if (f) {
+		GDKfree(f->args);
+		GDKfree(f);
+	}
+	GDKfree(def);
+	GDKfree(uses);
+	GDKfree(user);
+	GDKfree(size);
+	GDKfree(ops);
+	GDKfree(absorbed);
+	GDKfree(old);
 
-    if( OPTdebug &  OPTjit){
-        fprintf(stderr, "#JIT optimizer exit\n");
-        fprintFunction(stderr, mb, 0,  LIST_MAL_ALL);
-    }
+	if( OPTdebug &  OPTjit){
+		fprintf(stderr, "#JIT optimizer exit\n");
+		fprintFunction(stderr, mb, 0,  LIST_MAL_ALL);
+	}
 	return msg;
 }
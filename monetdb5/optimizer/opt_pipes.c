@@ -89,7 +89,7 @@ static struct PIPELINES {
 	 "optimizer.candidates();"
 	 "optimizer.postfix();"
 	 "optimizer.deadcode();"
-//	 "optimizer.jit();" awaiting the new batcalc api
+	 "optimizer.jit();"
 	 "optimizer.wlc();"
 	 "optimizer.garbageCollector();",
 	 "stable", NULL, NULL, 1},
@@ -125,7 +125,7 @@ static struct PIPELINES {
 	 "optimizer.candidates();"
 	 "optimizer.postfix();"
 	 "optimizer.deadcode();"
-//	 "optimizer.jit();" awaiting the new batcalc api
+	 "optimizer.jit();"
 	 "optimizer.oltp();"
 	 "optimizer.wlc();"
 	 "optimizer.garbageCollector();",
@@ -162,7 +162,44 @@ static struct PIPELINES {
 	 "optimizer.candidates();"
 	 "optimizer.postfix();"
 	 "optimizer.deadcode();"
-//	 "optimizer.jit();" awaiting the new batcalc api
+	 "optimizer.jit();"
+	 "optimizer.wlc();"
+	 "optimizer.garbageCollector();",
+	 "stable", NULL, NULL, 1},
+/*
+ * The recycler pipe keeps the intermediates of persistent data access in a
+ * server wide pool, such that queries repeating the same selections skip them.
+ */
+	{"recycler_pipe",
+	 "optimizer.inline();"
+	 "optimizer.remap();"
+	 "optimizer.costModel();"
+	 "optimizer.coercions();"
+	 "optimizer.aliases();"
+	 "optimizer.evaluate();"
+	 "optimizer.emptybind();"
+	 "optimizer.pushselect();"
+	 "optimizer.aliases();"
+	 "optimizer.mitosis();"
+	 "optimizer.mergetable();"
+	 "optimizer.deadcode();"
+	 "optimizer.aliases();"
+	 "optimizer.constants();"
+	 "optimizer.commonTerms();"
+	 "optimizer.projectionpath();"
+	 "optimizer.deadcode();"
+	 "optimizer.reorder();"
+	 "optimizer.matpack();"
+	 "optimizer.dataflow();"
+	 "optimizer.querylog();"
+	 "optimizer.multiplex();"
+	 "optimizer.generator();"
+	 "optimizer.profiler();"
+	 "optimizer.candidates();"
+	 "optimizer.postfix();"
+	 "optimizer.deadcode();"
+	 "optimizer.jit();"
+	 "optimizer.recycler();"
 	 "optimizer.wlc();"
 	 "optimizer.garbageCollector();",
 	 "stable", NULL, NULL, 1},
@@ -203,7 +240,7 @@ static struct PIPELINES {
 	 "optimizer.candidates();"
 	 "optimizer.postfix();"
 	 "optimizer.deadcode();"
-//	 "optimizer.jit();" awaiting the new batcalc api
+	 "optimizer.jit();"
 	 "optimizer.wlc();"
 	 "optimizer.garbageCollector();",
 	 "stable", NULL, NULL, 1},
@@ -243,7 +280,7 @@ static struct PIPELINES {
 	 "optimizer.candidates();"
 	 "optimizer.postfix();"
 	 "optimizer.deadcode();"
-//	 "optimizer.jit();" awaiting the new batcalc api
+	 "optimizer.jit();"
 	 "optimizer.wlc();"
 	 "optimizer.garbageCollector();",
 	 "stable", NULL, NULL, 1},
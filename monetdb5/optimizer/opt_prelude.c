@@ -133,6 +133,7 @@ str findRef;
 str finishRef;
 str firstnRef;
 str first_valueRef;
+str fusedRef;
 str generatorRef;
 str getRef;
 str getTraceRef;
@@ -436,6 +437,7 @@ void optimizerInit(void)
 	finishRef = putName("finish");
 	firstnRef = putName("firstn");
 	first_valueRef = putName("first_value");
+	fusedRef = putName("fused");
 	generatorRef = putName("generator");
 	getRef = putName("get");
 	getTraceRef = putName("getTrace");
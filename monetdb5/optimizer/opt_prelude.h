@@ -130,6 +130,7 @@ mal_export  str findRef;
 mal_export  str finishRef;
 mal_export  str firstnRef;
 mal_export  str first_valueRef;
+mal_export  str fusedRef;
 mal_export  str generatorRef;
 mal_export  str getRef;
 mal_export  str getTraceRef;
@@ -0,0 +1,119 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 1997 - July 2008 CWI, August 2008 - 2019 MonetDB B.V.
+ */
+
+/*
+ * The recycler optimizer marks the instructions whose results are kept
+ * in the recycle pool for reuse by later queries (see mal_recycle.c).
+ * The persistent columns accessed with sql.bind and sql.tid are the
+ * sources, whose version is checked by the SQL front-end. The side effect
+ * free algebra, aggregation, grouping, arithmetic and delta operations are
+ * recycled when all their BAT arguments are derived from the sources.
+ * A typical dashboard query then finds
+ *     X_5:bat[:int] := sql.bind(X_1, "sys", "t", "a", 0:int);
+ *     C_6:bat[:oid] := algebra.thetaselect(X_5, C_4, 10:int, ">");
+ *     X_9:bat[:int] := algebra.projection(C_6, X_5);
+ * in the pool, and skips them altogether.
+ */
+#include "monetdb_config.h"
+#include "mal_recycle.h"
+#include "opt_recycler.h"
+
+static bool
+OPTrecyclerDerived(MalBlkPtr mb, InstrPtr p, char *recycled)
+{
+	int i, tp;
+
+	if (getModuleId(p) == sqlRef) {
+		if (getFunctionId(p) != deltaRef && getFunctionId(p) != subdeltaRef &&
+			getFunctionId(p) != projectdeltaRef)
+			return false;
+	} else if (getModuleId(p) != algebraRef && getModuleId(p) != aggrRef &&
+			   getModuleId(p) != groupRef && getModuleId(p) != batcalcRef)
+		return false;
+	if (hasSideEffects(mb, p, TRUE) || isUnsafeFunction(p))
+		return false;
+	for (i = p->retc; i < p->argc; i++) {
+		tp = getArgType(mb, p, i);
+		if (isaBatType(tp)) {
+			if (!recycled[getArg(p, i)])
+				return false;
+		} else if (tp == TYPE_ptr || tp == TYPE_any)
+			return false;
+	}
+	return true;
+}
+
+str
+OPTrecyclerImplementation(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	int i, j, actions = 0;
+	InstrPtr p;
+	char *recycled = NULL;	/* variables produced by recycled instructions */
+	char *assigned = NULL;
+	char buf[256];
+	lng usec = GDKusec();
+	str msg = MAL_SUCCEED;
+
+	(void) cntxt;
+	(void) stk;
+	(void) pci;
+
+	if (mb->inlineProp)
+		return MAL_SUCCEED;
+
+	recycled = (char *) GDKzalloc(mb->vtop);
+	assigned = (char *) GDKzalloc(mb->vtop);
+	if (recycled == NULL || assigned == NULL) {
+		GDKfree(recycled);
+		GDKfree(assigned);
+		throw(MAL, "optimizer.recycler", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+	}
+
+	for (i = 0; i < mb->stop; i++) {
+		p = getInstrPtr(mb, i);
+		for (j = 0; j < p->retc; j++)
+			if (assigned[getArg(p, j)] < 2)
+				assigned[getArg(p, j)]++;
+	}
+	for (i = 1; i < mb->stop; i++) {
+		p = getInstrPtr(mb, i);
+		p->recycle = RECYCLE_NONE;
+		if ((p->token != CMDcall && p->token != PATcall) || p->barrier ||
+			p->argc > RECYCLEMAXARG)
+			continue;
+		if (getModuleId(p) == sqlRef &&
+			(getFunctionId(p) == bindRef || getFunctionId(p) == tidRef ||
+			 getFunctionId(p) == bindidxRef))
+			p->recycle = RECYCLE_SOURCE;
+		else if (OPTrecyclerDerived(mb, p, recycled))
+			p->recycle = RECYCLE_DERIVED;
+		else
+			continue;
+		/* variables assigned more than once can not be traced */
+		for (j = 0; j < p->retc; j++)
+			if (assigned[getArg(p, j)] > 1)
+				break;
+		if (j < p->retc) {
+			p->recycle = RECYCLE_NONE;
+			continue;
+		}
+		for (j = 0; j < p->retc; j++)
+			recycled[getArg(p, j)] = 1;
+		actions++;
+	}
+	GDKfree(recycled);
+	GDKfree(assigned);
+
+	/* keep all actions taken as a post block comment */
+	usec = GDKusec()- usec;
+	snprintf(buf,256,"%-20s actions=%2d time=" LLFMT " usec","recycler",actions, usec);
+	newComment(mb,buf);
+	if( actions >= 0)
+		addtoMalBlkHistory(mb);
+	return msg;
+}
@@ -45,6 +45,7 @@
 #include "opt_profiler.h"
 #include "opt_pushselect.h"
 #include "opt_querylog.h"
+#include "opt_recycler.h"
 #include "opt_reduce.h"
 #include "opt_remap.h"
 #include "opt_remoteQueries.h"
@@ -83,6 +84,7 @@ struct{
 	{"projectionpath", &OPTprojectionpathImplementation,0,0},
 	{"pushselect", &OPTpushselectImplementation,0,0},
 	{"querylog", &OPTquerylogImplementation,0,0},
+	{"recycler", &OPTrecyclerImplementation,0,0},
 	{"reduce", &OPTreduceImplementation,0,0},
 	{"remap", &OPTremapImplementation,0,0},
 	{"remoteQueries", &OPTremoteQueriesImplementation,0,0},
@@ -17,6 +17,7 @@
 #include "rel_updates.h"
 #include "rel_unnest.h"
 #include "rel_optimizer.h"
+#include "rel_matview.h"
 #include "sql_env.h"
 #include "sql_optimizer.h"
 
@@ -1881,6 +1882,38 @@ releqjoin( backend *be, list *l1, list *l2, int used_hash, comp_type cmp_op, int
 	return res;
 }
 
+/* range select the probe side of a join on the min and max of the join
+ * key of the build side (see rel_join_rangefilter) */
+static stmt *
+rel2bin_rangefilter(backend *be, list *keys, stmt *probe, stmt *build)
+{
+	mvc *sql = be->mvc;
+	sql_exp *pe = keys->h->data, *ke = keys->h->next->data;
+	stmt *pc, *kc, *lo, *hi, *sel;
+	list *l;
+	node *n;
+
+	pc = bin_find_column(be, probe, pe->l, pe->r);
+	kc = exp_bin(be, ke, build, NULL, NULL, NULL, NULL, NULL);
+	if (!pc || !kc || !kc->nrcols)
+		return probe;
+	lo = stmt_aggr(be, kc, NULL, NULL, sql_bind_aggr(sql->sa, sql->session->schema, "min", tail_type(kc)), 1, 0, 1);
+	hi = stmt_aggr(be, kc, NULL, NULL, sql_bind_aggr(sql->sa, sql->session->schema, "max", tail_type(kc)), 1, 0, 1);
+	sel = stmt_uselect2(be, pc, lo, hi, 3, NULL, 0);
+
+	l = sa_list(sql->sa);
+	for (n = probe->op4.lval->h; n; n = n->next) {
+		stmt *col = n->data;
+
+		if (col->nrcols == 0) /* constant */
+			col = stmt_const(be, sel, col);
+		else
+			col = stmt_project(be, sel, col);
+		list_append(l, col);
+	}
+	return stmt_list(be, l);
+}
+
 static stmt *
 rel2bin_join(backend *be, sql_rel *rel, list *refs)
 {
@@ -1890,6 +1923,7 @@ rel2bin_join(backend *be, sql_rel *rel, list *refs)
 	stmt *left = NULL, *right = NULL, *join = NULL, *jl, *jr;
 	stmt *ld = NULL, *rd = NULL;
 	int need_left = (rel->flag == LEFT_JOIN);
+	prop *rf;
 
 	if (rel->l) /* first construct the left sub relation */
 		left = subrel_bin(be, rel->l, refs);
@@ -1899,6 +1933,14 @@ rel2bin_join(backend *be, sql_rel *rel, list *refs)
 		return NULL;	
 	left = row2cols(be, left);
 	right = row2cols(be, right);
+	if (rel->op == op_join && (rf = find_prop(rel->p, PROP_RANGEFILTER)) != NULL) {
+		sql_exp *pe = ((list *) rf->value)->h->data;
+
+		if (bin_find_column(be, left, pe->l, pe->r))
+			left = rel2bin_rangefilter(be, rf->value, left, right);
+		else
+			right = rel2bin_rangefilter(be, rf->value, right, left);
+	}
 	/* 
  	 * split in 2 steps, 
  	 * 	first cheap join(s) (equality or idx) 
@@ -3527,10 +3569,10 @@ sql_insert_key(backend *be, list *inserts, sql_key *k, stmt *idx_inserts, stmt *
 	}
 }
 
-static int
-sql_stack_add_inserted( mvc *sql, const char *name, sql_table *t, stmt **updates) 
+static sql_rel *
+rel_inserted( mvc *sql, const char *name, sql_table *t, stmt **updates) 
 {
-	/* Put single relation of updates and old values on to the stack */
+	/* Single relation of the inserted values */
 	sql_rel *r = NULL;
 	node *n;
 	list *exps = sa_list(sql->sa);
@@ -3549,6 +3591,14 @@ sql_stack_add_inserted( mvc *sql, const char *name, sql_table *t, stmt **updates
 	}
 	r = rel_table_func(sql->sa, NULL, NULL, exps, 2);
 	r->l = ti;
+	return r;
+}
+
+static int
+sql_stack_add_inserted( mvc *sql, const char *name, sql_table *t, stmt **updates) 
+{
+	/* Put single relation of updates and old values on to the stack */
+	sql_rel *r = rel_inserted(sql, name, t, updates);
 
 	return stack_push_rel_view(sql, name, r) ? 1 : 0;
 }
@@ -3637,6 +3687,54 @@ table_update_stmts(mvc *sql, sql_table *t, int *Len)
 	return updates;
 }
 
+static stmt * sql_delete(backend *be, sql_table *t, stmt *rows);
+
+/* Bring the materialized views on t up to date, after inserting the
+ * updates into t or (updates == NULL) any other change of t. The new rows
+ * of an aggregating or recomputed view are computed before the old ones
+ * are deleted. */
+static int
+sql_matviews(backend *be, sql_table *t, stmt **updates)
+{
+	mvc *sql = be->mvc;
+	list *mvs = rel_matviews(sql, t), *refs = sa_list(sql->sa);
+	int cur_append = be->cur_append, res = 1;
+	node *n;
+
+	if (!mvs)
+		return 0;
+	be->cur_append = 0;
+	for (n = mvs->h; n && res; n = n->next) {
+		sql_table *mv = n->data;
+		sql_rel *r = NULL;
+		int merge = 1;
+
+		if (updates)
+			r = rel_matview_delta(sql, mv, t, rel_inserted(sql, t->base.name, t, updates), &merge);
+		if (!r) {
+			merge = 1;
+			r = rel_matview_query(sql, mv);
+		}
+		if (r)
+			r = rel_optimizer(sql, r, 0);
+		if (!r) {
+			res = 0;
+			break;
+		}
+		if (merge) {
+			r = rel_dup(r);
+			if (!subrel_bin(be, r, refs) || !sql_delete(be, mv, NULL)) {
+				res = 0;
+				break;
+			}
+		}
+		if (!subrel_bin(be, rel_insert(sql, rel_basetable(sql, mv, mv->base.name), r), refs))
+			res = 0;
+	}
+	be->cur_append = cur_append;
+	return res;
+}
+
 static stmt *
 rel2bin_insert(backend *be, sql_rel *rel, list *refs)
 {
@@ -3736,6 +3834,8 @@ rel2bin_insert(backend *be, sql_rel *rel, list *refs)
 	}
 	if (!sql_insert_triggers(be, t, updates, 1)) 
 		return sql_error(sql, 02, SQLSTATE(27000) "INSERT INTO: triggers failed for table '%s'", t->base.name);
+	if (!ddl && !sql_matviews(be, t, updates))
+		return sql_error(sql, 02, SQLSTATE(42000) "INSERT INTO: maintenance of materialized views failed for table '%s'", t->base.name);
 	if (ddl) {
 		ret = ddl;
 		list_prepend(l, ddl);
@@ -4743,6 +4843,8 @@ rel2bin_update(backend *be, sql_rel *rel, list *refs)
 	}
 	if (!sql_update_triggers(be, t, tids, updates, 1)) 
 		return sql_error(sql, 02, SQLSTATE(27000) "UPDATE: triggers failed for table '%s'", t->base.name);
+	if (!sql_matviews(be, t, NULL))
+		return sql_error(sql, 02, SQLSTATE(42000) "UPDATE: maintenance of materialized views failed for table '%s'", t->base.name);
 
 	if (ddl) {
 		list_prepend(l, ddl);
@@ -4822,8 +4924,6 @@ sql_delete_triggers(backend *be, sql_table *t, stmt *tids, int time, int firing_
 	return res;
 }
 
-static stmt * sql_delete(backend *be, sql_table *t, stmt *rows);
-
 static stmt *
 sql_delete_cascade_Fkeys(backend *be, sql_key *fk, stmt *ftids)
 {
@@ -4955,6 +5055,8 @@ sql_delete(backend *be, sql_table *t, stmt *rows)
 	}
 	if (!sql_delete_triggers(be, t, v, 1, 1, 3))
 		return sql_error(sql, 02, SQLSTATE(27000) "DELETE: triggers failed for table '%s'", t->base.name);
+	if (!sql_matviews(be, t, NULL))
+		return sql_error(sql, 02, SQLSTATE(42000) "DELETE: maintenance of materialized views failed for table '%s'", t->base.name);
 	if (rows)
 		s = stmt_aggr(be, rows, NULL, NULL, sql_bind_aggr(sql->sa, sql->session->schema, "count", NULL), 1, 0, 1);
 	if(be->cur_append) //building the total number of rows affected across all tables
@@ -5153,6 +5255,11 @@ sql_truncate(backend *be, sql_table *t, int restart_sequences, int cascade)
 			error = 1;
 			goto finalize;
 		}
+		if (!sql_matviews(be, next, NULL)) {
+			sql_error(sql, 02, SQLSTATE(42000) "TRUNCATE: maintenance of materialized views failed for table '%s'", next->base.name);
+			error = 1;
+			goto finalize;
+		}
 
 		if(be->cur_append) //building the total number of rows affected across all tables
 			other->nr = add_to_merge_partitions_accumulator(be, other->nr);
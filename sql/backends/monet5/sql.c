@@ -28,6 +28,7 @@
 #include "rel_optimizer.h"
 #include "rel_partition.h"
 #include "rel_distribute.h"
+#include "rel_matview.h"
 #include "rel_select.h"
 #include "rel_rel.h"
 #include "rel_exp.h"
@@ -122,6 +123,8 @@ sql_symbol2relation(mvc *c, symbol *sym)
 	r = rel_semantic(query, sym);
 	if (r)
 		r = rel_unnest(c, r);
+	if (r)
+		r = rel_matview_rewrite(c, r);
 	if (r)
 		r = rel_optimizer(c, r, 1);
 	if (r)
@@ -424,7 +427,7 @@ create_table_or_view(mvc *sql, char* sname, char *tname, sql_table *t, int temp)
 		}
 	}
 	/* also create dependencies when not renaming */
-	if (nt->query && isView(nt)) {
+	if (nt->query && (isView(nt) || isMatView(nt))) {
 		sql_rel *r = NULL;
 
 		sql->sa = sa_create();
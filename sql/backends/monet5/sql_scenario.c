@@ -34,6 +34,7 @@
 #include "mal_namespace.h"
 #include "mal_debugger.h"
 #include "mal_linker.h"
+#include "mal_recycle.h"
 #include "bat5.h"
 #include "wlc.h"
 #include "wlr.h"
@@ -70,10 +71,13 @@ monet5_freecode(int clientid, backend_code code, backend_stack stk, int nr, char
 {
 	str msg;
 
-	(void) code;
 	(void) stk;
 	(void) nr;
-	(void) clientid;
+	if (clientid < 0) {
+		/* private copy kept in the shared query cache */
+		freeSymbol((Symbol) code);
+		return;
+	}
 	msg = SQLCacheRemove(MCgetClient(clientid), name);
 	if (msg)
 		freeException(msg);	/* do something with error? */
@@ -83,6 +87,42 @@ monet5_freecode(int clientid, backend_code code, backend_stack stk, int nr, char
 #endif
 }
 
+/* Copy a query template, either into the namespace of a client or,
+ * if clientid < 0, into a private copy for the shared query cache.
+ * The function calls are resolved again in the context of the client. */
+static backend_code
+monet5_dupcode(int clientid, backend_code code, char *name)
+{
+	Symbol s = (Symbol) code, n;
+	MalBlkPtr mb;
+	int i;
+
+	if (s == NULL || (n = newSymbol(name ? name : s->name, s->kind)) == NULL)
+		return NULL;
+	if ((mb = copyMalBlk(s->def)) == NULL) {
+		freeSymbol(n);
+		return NULL;
+	}
+	freeMalBlk(n->def);
+	n->def = mb;
+	setFunctionId(getSignature(n), n->name);
+	for (i = 1; i < mb->stop; i++) {
+		InstrPtr p = getInstrPtr(mb, i);
+
+		if (p->blk) {
+			p->blk = NULL;
+			p->fcn = NULL;
+			p->typechk = TYPE_UNKNOWN;
+		}
+	}
+	if (clientid >= 0)
+		insertSymbol(MCgetClient(clientid)->usermodule, n);
+#ifdef _SQL_SCENARIO_DEBUG
+	fprintf(stderr, "#monet5_dupcode:%s\n", n->name);
+#endif
+	return n;
+}
+
 static str SQLinit(Client c);
 
 str
@@ -186,6 +226,9 @@ SQLexit(Client c)
 	(void) c;		/* not used */
 	MT_lock_set(&sql_contextLock);
 	if (SQLinitialized) {
+		RECYCLEversion = NULL;
+		RECYCLEreset();
+		qc_shared_destroy();
 		mvc_exit();
 		SQLinitialized = FALSE;
 	}
@@ -373,6 +416,51 @@ SQLresetClient(Client c)
 
 MT_Id sqllogthread, idlethread;
 
+/* The version of the column, index or table accessed by a recycled
+ * sql.bind, sql.bind_idxbat or sql.tid call. It is taken from the
+ * snapshot of the client transaction, which is bumped whenever another
+ * transaction commits changes to the object.
+ * Objects changed by the transaction itself and temporary tables
+ * are private to the client and are not recycled. */
+static lng
+SQLrecycleVersion(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	mvc *m = NULL;
+	sql_schema *s;
+	sql_table *t;
+	sql_base *b = NULL;
+	str msg;
+
+	if ((msg = getSQLContext(cntxt, mb, &m, NULL)) != MAL_SUCCEED) {
+		freeException(msg);
+		return -1;
+	}
+	if (getArgType(mb, pci, pci->retc + 1) != TYPE_str ||
+		getArgType(mb, pci, pci->retc + 2) != TYPE_str)
+		return -1;
+	s = mvc_bind_schema(m, *getArgReference_str(stk, pci, pci->retc + 1));
+	t = s ? mvc_bind_table(m, s, *getArgReference_str(stk, pci, pci->retc + 2)) : NULL;
+	if (t == NULL || !isTable(t) || t->persistence != SQL_PERSIST ||
+		t->commit_action || t->base.wtime)
+		return -1;
+	if (getFunctionId(pci) == tidRef) {
+		b = &t->base;
+	} else if (getArgType(mb, pci, pci->retc + 3) != TYPE_str) {
+		return -1;
+	} else if (getFunctionId(pci) == bindRef) {
+		sql_column *c = mvc_bind_column(m, t, *getArgReference_str(stk, pci, pci->retc + 3));
+		if (c)
+			b = &c->base;
+	} else {
+		sql_idx *i = mvc_bind_idx(m, s, *getArgReference_str(stk, pci, pci->retc + 3));
+		if (i && i->t == t)
+			b = &i->base;
+	}
+	if (b == NULL || b->wtime)
+		return -1;
+	return ((lng) b->id << 32) | (unsigned int) b->stime;
+}
+
 static str
 SQLinit(Client c)
 {
@@ -397,6 +485,7 @@ SQLinit(Client c)
 	be_funcs = (backend_functions) {
 		.fstack = &monet5_freestack,
 		.fcode = &monet5_freecode,
+		.fdupcode = &monet5_dupcode,
 		.fresolve_function = &monet5_resolve_function,
 	};
 	monet5_user_init(&be_funcs);
@@ -412,6 +501,8 @@ SQLinit(Client c)
 		throw(SQL, "SQLinit", SQLSTATE(42000) "Catalogue initialization failed");
 	}
 	SQLinitialized = TRUE;
+	qc_shared_init(GDKgetenv_int("sql_querycache", DEFAULT_SHAREDCACHESIZE));
+	RECYCLEversion = SQLrecycleVersion;
 	sqlinit = GDKgetenv("sqlinit");
 	if (sqlinit) {		/* add sqlinit to the fdin stack */
 		buffer *b = (buffer *) GDKmalloc(sizeof(buffer));
@@ -1025,6 +1116,67 @@ cachable(mvc *m, sql_rel *r)
 	return 1;
 }
 
+/*
+ * Query templates are shared with the other clients when they do not
+ * depend on the state of the client, i.e. uncommitted schema changes,
+ * local temporary tables or variables declared by the client.
+ */
+static int
+shareable(mvc *m)
+{
+	sql_schema *tmp;
+	node *n;
+
+	if (!caching(m) || m->emode != m_normal || qc_catalog_changed(m->session->tr) || m->topvars > NR_GLOBAL_VARS)
+		return 0;
+	if ((tmp = mvc_bind_schema(m, "tmp")) != NULL && tmp->tables.set) {
+		for (n = tmp->tables.set->h; n; n = n->next) {
+			sql_table *t = n->data;
+
+			if (t->persistence == SQL_LOCAL_TEMP || t->persistence == SQL_DECLARED_TABLE)
+				return 0;
+		}
+	}
+	return 1;
+}
+
+/* the SQL functions called by the template are compiled in the namespace
+ * of the client, which means it can not be used by the others */
+static int
+calls_private(Symbol s)
+{
+	int i;
+
+	for (i = 1; i < s->def->stop; i++)
+		if (getModuleId(getInstrPtr(s->def, i)) == userRef)
+			return 1;
+	return 0;
+}
+
+/* look for the query template in the shared cache */
+static cq *
+shared_match(mvc *m, char *q)
+{
+	char qname[IDLENGTH];
+	char *escaped_q;
+	cq *cq;
+
+	(void) snprintf(qname, IDLENGTH, "s%d_%d", m->qc->id, m->qc->clientid);
+	if ((escaped_q = sql_escape_str(q)) == NULL)
+		return NULL;
+	cq = qc_shared_match(m->qc, m, m->sa, qname, m->sym, m->args, m->argc, m->scanner.key ^ m->session->schema->base.id, escaped_q);
+	if (cq == NULL) {
+		GDKfree(escaped_q);
+		return NULL;
+	}
+	m->qc->id++;
+	cq->name = putName(cq->name);
+	/* passed over to query cache */
+	m->sa = NULL;
+	m->sym = NULL;
+	return cq;
+}
+
 /*
  * The core part of the SQL interface, parse the query and
  * store away the template (non)optimized code in the query cache
@@ -1041,7 +1193,7 @@ SQLparser(Client c)
 	mvc *m;
 	int oldvtop, oldstop;
 	int pstatus = 0;
-	int err = 0, opt = 0;
+	int err = 0, opt = 0, share = 0;
 	char *q = NULL;
 
 	be = (backend *) c->sqlcontext;
@@ -1221,6 +1373,12 @@ SQLparser(Client c)
 		/* query template was found in the query cache */
 		scanner_query_processed(&(m->scanner));
 		m->no_mitosis = be->q->no_mitosis;
+	} else if ((share = cachable(m, NULL) && shareable(m)) && (be->q = shared_match(m, q)) != NULL) {
+		/* query template was compiled by another client */
+		scanner_query_processed(&(m->scanner));
+		m->no_mitosis = be->q->no_mitosis;
+		if (!be->q->name)
+			err = 1;
 	} else {
 		sql_rel *r;
 
@@ -1278,6 +1436,8 @@ SQLparser(Client c)
 			be->q->code = (backend_code) backend_dumpproc(be, c, be->q, r);
 			if (!be->q->code)
 				err = 1;
+			else if (share && !c->curprg->def->errors && !calls_private(be->q->code))
+				qc_shared_insert(m, be->q);
 			be->q->stk = 0;
 
 			/* passed over to query cache, used during dumpproc */
@@ -20,6 +20,7 @@ analysis by optimizers.
 #include "monetdb_config.h"
 #include "sql_statistics.h"
 #include "sql_execute.h"
+#include "store_stats.h"
 
 str
 sql_drop_statistics(mvc *m, sql_table *t)
@@ -46,6 +47,7 @@ sql_drop_statistics(mvc *m, sql_table *t)
 		for (ncol = (t)->columns.set->h; ncol; ncol = ncol->next) {
 			sql_column *c = ncol->data;
 
+			stats_drop(c);
 			rid = table_funcs.column_find_row(tr, statsid, &c->base.id, NULL);
 			if (!is_oid_nil(rid) &&
 			    table_funcs.table_delete(tr, sysstats, rid) != LOG_OK)
@@ -241,6 +243,13 @@ sql_analyze(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 							strcpy(maxval, str_nil);
 							strcpy(minval, str_nil);
 						}
+						/* the value distribution for the optimizers */
+						if (!minmax && stats_analyze(c, bn) != LOG_OK) {
+							BBPunfix(bn->batCacheid);
+							GDKfree(maxval);
+							GDKfree(minval);
+							throw(SQL, "analyze", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+						}
 						BBPunfix(bn->batCacheid);
 						ts = timestamp_current();
 						if (!is_oid_nil(rid) && table_funcs.table_delete(tr, sysstats, rid) != LOG_OK) {
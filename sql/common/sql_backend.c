@@ -42,6 +42,14 @@ backend_freecode(int clientid, backend_code code, backend_stack stk, int nr, cha
 		be_funcs.fcode(clientid, code, stk, nr, name);
 }
 
+backend_code
+backend_dupcode(int clientid, backend_code code, char *name)
+{
+	if (be_funcs.fdupcode != NULL)
+		return be_funcs.fdupcode(clientid, code, name);
+	return NULL;
+}
+
 char *
 backend_create_user(ptr mvc, char *user, char *passwd, char enc, char *fullname, sqlid defschemid, sqlid grantor)
 {
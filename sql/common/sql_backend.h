@@ -16,6 +16,7 @@
 
 typedef void (*freestack_fptr) (int clientid, backend_stack stk);
 typedef void (*freecode_fptr) (int clientid, backend_code code, backend_stack stk, int nr, char *name);
+typedef backend_code (*dupcode_fptr) (int clientid, backend_code code, char *name);
 
 typedef char *(*create_user_fptr) (ptr mvc, char *user, char *passwd, char enc, char *fullname, sqlid schema_id, sqlid grantor_id);
 typedef int  (*drop_user_fptr) (ptr mvc, char *user);
@@ -32,6 +33,7 @@ typedef int  (*resolve_function) (ptr mvc, sql_func *f);
 typedef struct _backend_functions {
 	freestack_fptr fstack;
 	freecode_fptr fcode;
+	dupcode_fptr fdupcode;
 	create_user_fptr fcuser;
 	drop_user_fptr fduser;
 	find_user_fptr ffuser;
@@ -45,6 +47,7 @@ typedef struct _backend_functions {
 
 extern void backend_freestack(int clientid, backend_stack stk);
 extern void backend_freecode(int clientid, backend_code code, backend_stack stk, int nr, char *name);
+extern backend_code backend_dupcode(int clientid, backend_code code, char *name);
 
 extern char *backend_create_user(ptr mvc, char *user, char *passwd, char enc, char *fullname, sqlid defschemid, sqlid grantor);
 extern int  backend_drop_user(ptr mvc, char *user);
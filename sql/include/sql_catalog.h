@@ -574,6 +574,7 @@ typedef enum table_types {
 #define isReplicaTable(x)                 (x->type==tt_replica_table)
 #define isKindOfTable(x)                  (isTable(x) || isMergeTable(x) || isRemote(x) || isReplicaTable(x))
 #define isPartition(x)                    (isTable(x) && x->p)
+#define isMatView(x)                      (isTable(x) && x->query)
 
 #define TABLE_WRITABLE	0
 #define TABLE_READONLY	1
@@ -0,0 +1,601 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 1997 - July 2008 CWI, August 2008 - 2019 MonetDB B.V.
+ */
+
+/*
+ * Materialized views are tables which keep the statement defining them
+ * (CREATE MATERIALIZED VIEW ... AS query) in t->query. As for normal
+ * views, instantiating the statement gives the relation of the query.
+ *
+ * The views are kept up to date by the statements changing their tables,
+ * within the same transaction. The rows inserted in a table are pushed
+ * through the query of the view instead of the table (the delta). For
+ * select-project-join views the delta is appended to the view. For views
+ * aggregating with count, sum, min and max, the delta is merged with the
+ * current rows of the view and re-aggregated per group, which costs in the
+ * size of the view and of the inserts, not of the table. Other views, and
+ * all updates and deletes, recompute the view.
+ *
+ * A query grouping a table is answered from an aggregating view on that
+ * table, if the view groups on all the group by and selection columns of
+ * the query and has all its aggregates.
+ */
+
+#include "monetdb_config.h"
+#include "rel_matview.h"
+#include "rel_rel.h"
+#include "rel_exp.h"
+#include "rel_semantic.h"
+#include "rel_unnest.h"
+#include "sql_privileges.h"
+
+/* the materialized views on table t */
+list *
+rel_matviews(mvc *sql, sql_table *t)
+{
+	sql_trans *tr = sql->session->tr;
+	list *res = sa_list(sql->sa), *deps;
+	node *n, *m;
+
+	if (!isTable(t) || isTempTable(t) || !t->s)
+		return res;
+	if (!(deps = sql_trans_get_dependencies(tr, t->base.id, VIEW_DEPENDENCY, NULL)))
+		return NULL;
+	for (n = deps->h; n && n->next; n = n->next->next) {
+		sqlid id = *(sqlid *) n->data;
+		sql_table *mv = NULL;
+
+		if (*(sht *) n->next->data != VIEW_DEPENDENCY)
+			continue;
+		for (m = tr->schemas.set->h; m && !mv; m = m->next)
+			mv = find_sql_table_id(m->data, id);
+		if (mv && isMatView(mv) && !list_find(res, mv, NULL))
+			append(res, mv);
+	}
+	list_destroy(deps);
+	return res;
+}
+
+/* the first table used by rel (parsed in m_deps mode), which is not a
+ * persistent table. Views on these cannot be maintained */
+sql_table *
+rel_matview_bad_source(mvc *sql, sql_rel *rel)
+{
+	sql_trans *tr = sql->session->tr;
+	list *ids = rel_dependencies(sql, rel);
+	node *n, *m;
+
+	if (!ids)
+		return NULL;
+	for (n = ids->h; n; n = n->next) {
+		sqlid id = *(sqlid *) n->data;
+		sql_table *t = NULL;
+
+		for (m = tr->schemas.set->h; m && !t; m = m->next)
+			t = find_sql_table_id(m->data, id);
+		if (t && (!isTable(t) || isTempTable(t) || isMatView(t)))
+			return t;
+	}
+	return NULL;
+}
+
+sql_rel *
+rel_matview_query(mvc *sql, sql_table *mv)
+{
+	sql_rel *rel = rel_parse(sql, mv->s, mv->query, m_instantiate);
+
+	if (rel)
+		rel = rel_unnest(sql, rel);
+	return rel;
+}
+
+static int
+exps_have_analytic(list *exps)
+{
+	node *n;
+
+	if (exps) {
+		for (n = exps->h; n; n = n->next) {
+			sql_exp *e = n->data;
+
+			if (is_analytic(e))
+				return 1;
+		}
+	}
+	return 0;
+}
+
+/* the number of times t is used by rel, -1 if the inserts in t cannot be
+ * pushed through rel */
+static int
+rel_matview_spj(sql_rel *rel, sql_table *t)
+{
+	int l, r;
+
+	if (!rel)
+		return 0;
+	switch (rel->op) {
+	case op_basetable:
+		return rel->l == t;
+	case op_join:
+		l = rel_matview_spj(rel->l, t);
+		r = rel_matview_spj(rel->r, t);
+		return (l < 0 || r < 0) ? -1 : l + r;
+	case op_select:
+		return rel_matview_spj(rel->l, t);
+	case op_project:
+		if (need_distinct(rel) || exps_have_analytic(rel->exps))
+			return -1;
+		return rel_matview_spj(rel->l, t);
+	default:
+		return -1;
+	}
+}
+
+/* replace base table t by the inserted rows, whose columns are named
+ * after t */
+static sql_rel *
+rel_matview_replace(mvc *sql, sql_rel *rel, sql_table *t, sql_rel *inserts)
+{
+	if (!rel)
+		return rel;
+	if (is_basetable(rel->op)) {
+		list *exps;
+		node *n;
+
+		if (rel->l != t)
+			return rel;
+		exps = new_exp_list(sql->sa);
+		for (n = rel->exps->h; n; n = n->next) {
+			sql_exp *e = n->data;
+
+			if (!is_intern(e))
+				append(exps, exp_alias(sql->sa, exp_relname(e), exp_name(e), t->base.name, e->r, exp_subtype(e), CARD_MULTI, has_nil(e), 0));
+		}
+		return rel_project(sql->sa, inserts, exps);
+	}
+	rel->l = rel_matview_replace(sql, rel->l, t, inserts);
+	if (is_join(rel->op))
+		rel->r = rel_matview_replace(sql, rel->r, t, inserts);
+	return rel;
+}
+
+static int
+exp_same_name(sql_exp *e1, sql_exp *e2)
+{
+	const char *r1 = exp_relname(e1), *r2 = exp_relname(e2);
+
+	if (!exp_name(e1) || !exp_name(e2) || strcmp(exp_name(e1), exp_name(e2)) != 0)
+		return 0;
+	return (!r1 && !r2) || (r1 && r2 && strcmp(r1, r2) == 0);
+}
+
+static sql_exp *
+exps_find_ref(list *exps, sql_exp *e)
+{
+	if (e->type != e_column)
+		return NULL;
+	if (e->l)
+		return exps_bind_column2(exps, e->l, e->r);
+	return exps_bind_column(exps, e->r, NULL);
+}
+
+/* the aggregates re-aggregating the columns of view q, NULL for its
+ * groups */
+static int
+rel_matview_aggrs(sql_rel *q, sql_rel *gb, const char **aggrs)
+{
+	node *n, *m;
+	int i = 0;
+
+	for (n = q->exps->h; n; n = n->next, i++) {
+		sql_exp *ge = exps_find_ref(gb->exps, n->data);
+
+		if (!ge)
+			return 0;
+		if (ge->type == e_aggr) {
+			const char *aname = ((sql_subaggr *) ge->f)->aggr->base.name;
+
+			if (need_distinct(ge))
+				return 0;
+			if (strcmp(aname, "count") == 0 || strcmp(aname, "sum") == 0)
+				aggrs[i] = "sum";
+			else if (strcmp(aname, "min") == 0 || strcmp(aname, "max") == 0)
+				aggrs[i] = aname;
+			else
+				return 0;
+		} else if (ge->type != e_column) {
+			return 0;
+		}
+	}
+	/* all groups should be in the view */
+	if (gb->r) {
+		for (m = ((list *) gb->r)->h; m; m = m->next) {
+			for (n = q->exps->h, i = 0; n; n = n->next, i++) {
+				sql_exp *ge = exps_find_ref(gb->exps, n->data);
+
+				if (!aggrs[i] && exp_same_name(ge, m->data))
+					break;
+			}
+			if (!n)
+				return 0;
+		}
+	}
+	return 1;
+}
+
+/* group the current rows of view mv together with its delta q */
+static sql_rel *
+rel_matview_merge(mvc *sql, sql_table *mv, sql_rel *q, const char **aggrs)
+{
+	sql_allocator *sa = sql->sa;
+	const char *tname = mv->base.name;
+	list *lexps = new_exp_list(sa), *rexps = new_exp_list(sa), *groups = new_exp_list(sa), *exps = new_exp_list(sa);
+	sql_rel *u, *g;
+	node *n, *m;
+	int i;
+
+	if (list_length(q->exps) != list_length(mv->columns.set))
+		return NULL;
+	for (n = mv->columns.set->h, m = q->exps->h; n && m; n = n->next, m = m->next) {
+		sql_column *c = n->data;
+		sql_exp *e = exp_ref(sa, (sql_exp *) m->data);
+
+		if (subtype_cmp(exp_subtype(e), &c->type) != 0)
+			e = exp_convert(sa, e, exp_subtype(e), &c->type);
+		exp_setname(sa, e, tname, c->base.name);
+		append(rexps, e);
+		append(lexps, exp_column(sa, tname, c->base.name, &c->type, CARD_MULTI, c->null, 0));
+	}
+	u = rel_setop(sa, rel_project(sa, rel_basetable(sql, mv, tname), lexps), rel_project(sa, q, rexps), op_union);
+	u->exps = rel_projections(sql, u->l, NULL, 1, 0);
+	set_processed(u);
+
+	for (n = mv->columns.set->h, i = 0; n; n = n->next, i++) {
+		sql_column *c = n->data;
+
+		if (!aggrs[i])
+			append(groups, exp_column(sa, tname, c->base.name, &c->type, CARD_MULTI, c->null, 0));
+	}
+	g = rel_groupby(sql, u, list_empty(groups) ? NULL : groups);
+	for (n = mv->columns.set->h, i = 0; n; n = n->next, i++) {
+		sql_column *c = n->data;
+		sql_exp *e;
+
+		if (aggrs[i]) {
+			sql_subaggr *a = sql_bind_aggr(sa, sql->session->schema, aggrs[i], &c->type);
+
+			if (!a)
+				return NULL;
+			e = exp_column(sa, tname, c->base.name, &c->type, CARD_MULTI, c->null, 0);
+			e = rel_groupby_add_aggr(sql, g, exp_aggr1(sa, e, a, 0, 1, CARD_AGGR, c->null));
+			if (subtype_cmp(exp_subtype(e), &c->type) != 0)
+				e = exp_convert(sa, e, exp_subtype(e), &c->type);
+		} else {
+			e = exp_column(sa, tname, c->base.name, &c->type, CARD_AGGR, c->null, 0);
+		}
+		append(exps, e);
+	}
+	return rel_project(sa, g, exps);
+}
+
+/* the rows to add to view mv for the inserts in t. For aggregating views
+ * these replace all rows of the view (merge is set). NULL when the view
+ * should be recomputed */
+sql_rel *
+rel_matview_delta(mvc *sql, sql_table *mv, sql_table *t, sql_rel *inserts, int *merge)
+{
+	sql_rel *q = rel_matview_query(sql, mv), *gb = NULL;
+
+	*merge = 0;
+	if (!q || !is_simple_project(q->op))
+		return NULL;
+	if (q->l && is_groupby(((sql_rel *) q->l)->op))
+		gb = q->l;
+	if (gb) {
+		const char **aggrs = SA_ZNEW_ARRAY(sql->sa, const char *, list_length(q->exps));
+
+		if (rel_matview_spj(gb->l, t) != 1 || !rel_matview_aggrs(q, gb, aggrs))
+			return NULL;
+		gb->l = rel_matview_replace(sql, gb->l, t, inserts);
+		*merge = 1;
+		return rel_matview_merge(sql, mv, q, aggrs);
+	}
+	if (rel_matview_spj(q, t) != 1)
+		return NULL;
+	return rel_matview_replace(sql, q, t, inserts);
+}
+
+/* a column of view, the aggregate (NULL for the groups) and the column of
+ * the table aggregated (NULL for count(*)) */
+typedef struct mv_col {
+	const char *aggr;
+	const char *cname;
+} mv_col;
+
+static int
+mv_find(mv_col *cols, int nr, const char *aggr, const char *cname)
+{
+	int i;
+
+	for (i = 0; i < nr; i++) {
+		if ((!aggr) != (!cols[i].aggr) || (aggr && strcmp(aggr, cols[i].aggr) != 0))
+			continue;
+		if ((!cname) != (!cols[i].cname) || (cname && strcmp(cname, cols[i].cname) != 0))
+			continue;
+		return i;
+	}
+	return -1;
+}
+
+static sql_exp *
+rel_matview_column(sql_rel *bt, sql_exp *e)
+{
+	sql_exp *c = exps_find_ref(bt->exps, e);
+
+	return (c && !is_intern(c)) ? c : NULL;
+}
+
+/* the columns of view mv, when it groups table t without selections */
+static mv_col *
+rel_matview_describe(mvc *sql, sql_table *mv, sql_table *t)
+{
+	sql_rel *q = rel_matview_query(sql, mv), *gb, *bt;
+	mv_col *cols;
+	node *n;
+	int i = 0;
+
+	if (!q) {
+		sql->session->status = 0;
+		sql->errstr[0] = '\0';
+		return NULL;
+	}
+	if (!is_simple_project(q->op) || !(gb = q->l) || !is_groupby(gb->op) ||
+	    !(bt = gb->l) || !is_basetable(bt->op) || bt->l != t ||
+	    list_length(q->exps) != list_length(mv->columns.set))
+		return NULL;
+	cols = SA_ZNEW_ARRAY(sql->sa, mv_col, list_length(q->exps));
+	for (n = q->exps->h; n; n = n->next, i++) {
+		sql_exp *ge = exps_find_ref(gb->exps, n->data), *c = NULL;
+
+		if (!ge)
+			return NULL;
+		if (ge->type == e_aggr) {
+			list *args = ge->l;
+
+			if (need_distinct(ge) || list_length(args) > 1)
+				return NULL;
+			if (!list_empty(args) && !(c = rel_matview_column(bt, args->h->data)))
+				return NULL;
+			cols[i].aggr = ((sql_subaggr *) ge->f)->aggr->base.name;
+		} else if (!(c = rel_matview_column(bt, ge))) {
+			return NULL;
+		}
+		cols[i].cname = c ? c->r : NULL;
+	}
+	return cols;
+}
+
+static int exp_matview_groups(sql_exp *e, sql_rel *bt, mv_col *cols, int nr);
+
+static int
+exps_matview_groups(list *exps, sql_rel *bt, mv_col *cols, int nr)
+{
+	node *n;
+
+	if (exps)
+		for (n = exps->h; n; n = n->next)
+			if (!exp_matview_groups(n->data, bt, cols, nr))
+				return 0;
+	return 1;
+}
+
+/* does e only use columns grouped by the view */
+static int
+exp_matview_groups(sql_exp *e, sql_rel *bt, mv_col *cols, int nr)
+{
+	sql_exp *c;
+
+	switch (e->type) {
+	case e_column:
+		c = rel_matview_column(bt, e);
+		return c && mv_find(cols, nr, NULL, c->r) >= 0;
+	case e_atom:
+		return !e->f || exps_matview_groups(e->f, bt, cols, nr);
+	case e_convert:
+		return exp_matview_groups(e->l, bt, cols, nr);
+	case e_func:
+		return exps_matview_groups(e->l, bt, cols, nr);
+	case e_cmp:
+		if (get_cmp(e) == cmp_or || get_cmp(e) == cmp_filter)
+			return exps_matview_groups(e->l, bt, cols, nr) && exps_matview_groups(e->r, bt, cols, nr);
+		if (e->flag == cmp_in || e->flag == cmp_notin)
+			return exp_matview_groups(e->l, bt, cols, nr) && exps_matview_groups(e->r, bt, cols, nr);
+		return exp_matview_groups(e->l, bt, cols, nr) && exp_matview_groups(e->r, bt, cols, nr) &&
+			(!e->f || exp_matview_groups(e->f, bt, cols, nr));
+	default:
+		return 0;
+	}
+}
+
+/* the view column holding aggregate e of the query, -1 if there is none */
+static int
+rel_matview_find_aggr(sql_rel *bt, sql_exp *e, mv_col *cols, int nr)
+{
+	list *args = e->l;
+	sql_exp *c = NULL;
+	const char *aname = ((sql_subaggr *) e->f)->aggr->base.name;
+
+	if (need_distinct(e) || list_length(args) > 1)
+		return -1;
+	if (strcmp(aname, "count") != 0 && strcmp(aname, "sum") != 0 &&
+	    strcmp(aname, "min") != 0 && strcmp(aname, "max") != 0)
+		return -1;
+	if (!list_empty(args) && !(c = rel_matview_column(bt, args->h->data)))
+		return -1;
+	return mv_find(cols, nr, aname, c ? c->r : NULL);
+}
+
+static int
+rel_matview_covers(sql_rel *gb, sql_rel *sel, sql_rel *bt, mv_col *cols, int nr)
+{
+	node *n;
+
+	if (!exps_matview_groups(gb->r, bt, cols, nr))
+		return 0;
+	if (sel && !exps_matview_groups(sel->exps, bt, cols, nr))
+		return 0;
+	for (n = gb->exps->h; n; n = n->next) {
+		sql_exp *e = n->data;
+
+		if (e->type == e_column) {
+			if (!exp_matview_groups(e, bt, cols, nr))
+				return 0;
+		} else if (e->type != e_aggr || rel_matview_find_aggr(bt, e, cols, nr) < 0) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* answer the grouping gb from the view grouping on the least columns */
+static sql_rel *
+rel_matview_answer(mvc *sql, sql_rel *gb)
+{
+	sql_allocator *sa = sql->sa;
+	sql_rel *sel = NULL, *bt = gb->l, *p, *g;
+	sql_table *mv = NULL;
+	sql_subaggr **aggrs;
+	mv_col *cols = NULL;
+	list *mvs, *exps;
+	node *n;
+	int nr = 0, groups = 0, i;
+
+	if (list_empty(gb->r) || !bt)
+		return NULL;
+	if (is_select(bt->op) && !rel_is_ref(bt)) {
+		sel = bt;
+		bt = sel->l;
+	}
+	if (!bt || !is_basetable(bt->op) || rel_is_ref(bt) || !(mvs = rel_matviews(sql, bt->l)))
+		return NULL;
+	for (n = mvs->h; n; n = n->next) {
+		sql_table *v = n->data;
+		int vnr = list_length(v->columns.set), vgroups = 0;
+		mv_col *c;
+
+		if (!table_privs(sql, v, PRIV_SELECT) || !(c = rel_matview_describe(sql, v, bt->l)) ||
+		    !rel_matview_covers(gb, sel, bt, c, vnr))
+			continue;
+		for (i = 0; i < vnr; i++)
+			vgroups += !c[i].aggr;
+		if (!mv || vgroups < groups) {
+			mv = v;
+			cols = c;
+			nr = vnr;
+			groups = vgroups;
+		}
+	}
+	if (!mv)
+		return NULL;
+
+	/* counts are summed, the other aggregates are applied again */
+	aggrs = SA_ZNEW_ARRAY(sa, sql_subaggr *, list_length(gb->exps));
+	for (n = gb->exps->h, i = 0; n; n = n->next, i++) {
+		sql_exp *e = n->data;
+		sql_column *c;
+		const char *aname;
+
+		if (e->type != e_aggr)
+			continue;
+		c = list_fetch(mv->columns.set, rel_matview_find_aggr(bt, e, cols, nr));
+		aname = ((sql_subaggr *) e->f)->aggr->base.name;
+		if (!(aggrs[i] = sql_bind_aggr(sa, sql->session->schema, strcmp(aname, "count") == 0 ? "sum" : aname, &c->type)))
+			return NULL;
+	}
+
+	/* the groups get the names of the columns of the table */
+	exps = new_exp_list(sa);
+	for (n = mv->columns.set->h, i = 0; n; n = n->next, i++) {
+		sql_column *c = n->data;
+
+		if (cols[i].aggr)
+			append(exps, exp_alias(sa, mv->base.name, c->base.name, mv->base.name, c->base.name, &c->type, CARD_MULTI, c->null, 0));
+		else
+			append(exps, exp_alias(sa, rel_name(bt), cols[i].cname, mv->base.name, c->base.name, &c->type, CARD_MULTI, c->null, 0));
+	}
+	p = rel_project(sa, rel_basetable(sql, mv, mv->base.name), exps);
+	if (sel)
+		sel->l = p;
+	g = rel_groupby(sql, sel ? sel : p, gb->r);
+
+	exps = new_exp_list(sa);
+	for (n = gb->exps->h, i = 0; n; n = n->next, i++) {
+		sql_exp *e = n->data, *ne;
+
+		if (aggrs[i]) {
+			sql_column *c = list_fetch(mv->columns.set, rel_matview_find_aggr(bt, e, cols, nr));
+
+			ne = exp_column(sa, mv->base.name, c->base.name, &c->type, CARD_MULTI, c->null, 0);
+			ne = rel_groupby_add_aggr(sql, g, exp_aggr1(sa, ne, aggrs[i], 0, 1, CARD_AGGR, c->null));
+			if (subtype_cmp(exp_subtype(ne), exp_subtype(e)) != 0)
+				ne = exp_convert(sa, ne, exp_subtype(ne), exp_subtype(e));
+			exp_setname(sa, ne, exp_relname(e), exp_name(e));
+		} else {
+			ne = exp_ref(sa, e);
+		}
+		append(exps, ne);
+	}
+	return rel_project(sa, g, exps);
+}
+
+static sql_rel *
+rel_matview_rewrite_(mvc *sql, sql_rel *rel)
+{
+	if (!rel || THRhighwater())
+		return rel;
+
+	switch (rel->op) {
+	case op_join:
+	case op_left:
+	case op_right:
+	case op_full:
+	case op_semi:
+	case op_anti:
+	case op_union:
+	case op_inter:
+	case op_except:
+		rel->l = rel_matview_rewrite_(sql, rel->l);
+		rel->r = rel_matview_rewrite_(sql, rel->r);
+		break;
+	case op_project:
+	case op_select:
+	case op_groupby:
+	case op_topn:
+	case op_sample:
+		rel->l = rel_matview_rewrite_(sql, rel->l);
+		break;
+	default:
+		return rel;
+	}
+	if (is_groupby(rel->op) && !rel_is_ref(rel)) {
+		sql_rel *nrel = rel_matview_answer(sql, rel);
+
+		if (nrel)
+			return nrel;
+	}
+	return rel;
+}
+
+/* answer the groupings of a query from the materialized views */
+sql_rel *
+rel_matview_rewrite(mvc *sql, sql_rel *rel)
+{
+	if (!rel || is_ddl(rel->op) || is_modify(rel->op))
+		return rel;
+	return rel_matview_rewrite_(sql, rel);
+}
@@ -0,0 +1,21 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 1997 - July 2008 CWI, August 2008 - 2019 MonetDB B.V.
+ */
+
+#ifndef _REL_MATVIEW_H_
+#define _REL_MATVIEW_H_
+
+#include "sql_relation.h"
+#include "sql_mvc.h"
+
+extern list *rel_matviews(mvc *sql, sql_table *t);
+extern sql_table *rel_matview_bad_source(mvc *sql, sql_rel *rel);
+extern sql_rel *rel_matview_query(mvc *sql, sql_table *mv);
+extern sql_rel *rel_matview_delta(mvc *sql, sql_table *mv, sql_table *t, sql_rel *inserts, int *merge);
+extern sql_rel *rel_matview_rewrite(mvc *sql, sql_rel *rel);
+
+#endif /*_REL_MATVIEW_H_ */
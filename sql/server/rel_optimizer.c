@@ -848,18 +848,14 @@ order_joins(mvc *sql, list *rels, list *exps)
 	/* find foreign keys and reorder the expressions on reducing quality */
 	sdje = find_fk(sql, rels, exps);
 
-	if (list_length(rels) > 2 && mvc_debug_on(sql, 256)) {
-		for(djn = sdje->h; djn; djn = djn->next ) {
-			sql_exp *e = djn->data;
-			list_remove_data(exps, e);
-		}
-		top =  rel_planner(sql, rels, sdje, exps);
-		return top;
-	}
-
-	/* open problem, some expressions use more than 2 relations */
-	/* For example a.x = b.y * c.z; */
-	if (list_length(rels) >= 2 && sdje->h) {
+	/* order the joins on the estimated sizes, unless the heuristic
+	 * order is requested (debug 256) or the sizes are unknown */
+	if (list_length(rels) > 2 && !mvc_debug_on(sql, 256) &&
+	    (top = rel_planner(sql, rels, sdje, exps)) != NULL) {
+		/* the remaining expressions are added as selections below */
+	} else if (list_length(rels) >= 2 && sdje->h) {
+		/* open problem, some expressions use more than 2 relations */
+		/* For example a.x = b.y * c.z; */
 		/* get the first expression */
 		cje = sdje->h->data;
 
@@ -4270,6 +4266,168 @@ gen_push_groupby_down(int *changes, mvc *sql, sql_rel *rel)
 	return rel;
 }
 
+/*
+ * Eager aggregation: when a group by on a join only groups on columns of
+ * one side (D) and only aggregates columns of the other (F), the rows of F
+ * can be aggregated on the join keys first. Each such group joins as a
+ * whole, so the aggregates are combined per group of D afterwards
+ * (counts are summed).
+ *
+ * 	group by (
+ * 	  join(F, D) [ F.k = D.k ]
+ * 	) [ D.g ] [ D.g, sum(F.a), count(*) ]
+ * ->
+ * 	project (
+ * 	  group by (
+ * 	    join(
+ * 	      group by (F) [ F.k ] [ F.k, sum(F.a) as s, count(*) as c ],
+ * 	      D
+ * 	    ) [ F.k = D.k ]
+ * 	  ) [ D.g ] [ D.g, sum(s), sum(c) ]
+ * 	) [ D.g, .. ]
+ *
+ * This is done when F has several tuples per join key, as estimated from
+ * the statistics of the keys, as then the join and the final grouping get
+ * a fraction of the tuples of F.
+ */
+#define EAGER_AGGR_TUPLES 4	/* least tuples per key of F */
+
+static int
+exps_all_in_rel(sql_rel *rel, list *exps)
+{
+	node *n;
+
+	if (exps)
+		for (n = exps->h; n; n = n->next)
+			if (!rel_find_exp(rel, n->data))
+				return 0;
+	return 1;
+}
+
+static int
+exp_aggr_is_eager(sql_exp *e)
+{
+	const char *aname;
+
+	if (e->type != e_aggr || need_distinct(e) || list_length(e->l) > 1)
+		return 0;
+	aname = ((sql_subaggr *) e->f)->aggr->base.name;
+	return strcmp(aname, "count") == 0 || strcmp(aname, "sum") == 0 ||
+	       strcmp(aname, "min") == 0 || strcmp(aname, "max") == 0;
+}
+
+static sql_rel *
+rel_push_aggr_eager(int *changes, mvc *sql, sql_rel *rel)
+{
+	sql_rel *j = rel->l, *f, *d, *egb;
+	list *gbe = rel->r, *keys, *exps, *pexps;
+	lng cnt, dcnt = 1;
+	node *n;
+	int left;
+
+	if (!is_groupby(rel->op) || rel_is_ref(rel) || list_empty(gbe) ||
+	    !j || j->op != op_join || rel_is_ref(j) || list_empty(j->exps))
+		return rel;
+	if (exps_all_in_rel(j->r, gbe))
+		left = 1;
+	else if (exps_all_in_rel(j->l, gbe))
+		left = 0;
+	else
+		return rel;
+	f = left ? j->l : j->r;
+	d = left ? j->r : j->l;
+	if (is_groupby(f->op) || rel_is_ref(f))
+		return rel;
+
+	for (n = rel->exps->h; n; n = n->next) {
+		sql_exp *e = n->data;
+
+		if (e->type == e_aggr) {
+			if (!exp_aggr_is_eager(e) || !exps_all_in_rel(f, e->l))
+				return rel;
+		} else if (e->type != e_column || !rel_find_exp(d, e)) {
+			return rel;
+		}
+	}
+
+	/* the join keys of F */
+	keys = new_exp_list(sql->sa);
+	for (n = j->exps->h; n; n = n->next) {
+		sql_exp *je = n->data, *fe, *de;
+
+		if (je->type != e_cmp || get_cmp(je) != cmp_equal || is_anti(je))
+			return rel;
+		if ((fe = rel_find_exp(f, je->l)) != NULL)
+			de = rel_find_exp(d, je->r);
+		else if ((fe = rel_find_exp(f, je->r)) != NULL)
+			de = rel_find_exp(d, je->l);
+		else
+			return rel;
+		if (!de || fe->type != e_column)
+			return rel;
+		if (!exps_find_exp(keys, fe))
+			append(keys, fe);
+	}
+
+	if ((cnt = rel_est_count(sql, f)) <= 0)
+		return rel;
+	for (n = keys->h; n && dcnt < cnt; n = n->next) {
+		lng k = rel_est_distinct(sql, f, exp_ref(sql->sa, (sql_exp *) n->data));
+
+		if (k <= 0)
+			return rel;
+		dcnt = (dcnt > cnt / k) ? cnt : dcnt * k;
+	}
+	if (dcnt * EAGER_AGGR_TUPLES > cnt)
+		return rel;
+
+	/* group F on its join keys */
+	exps = new_exp_list(sql->sa);
+	for (n = keys->h; n; n = n->next)
+		append(exps, exp_ref(sql->sa, (sql_exp *) n->data));
+	egb = rel_groupby(sql, f, exps);
+	if (left)
+		j->l = egb;
+	else
+		j->r = egb;
+
+	/* and combine its aggregates per group */
+	exps = new_exp_list(sql->sa);
+	pexps = new_exp_list(sql->sa);
+	for (n = rel->exps->h; n; n = n->next) {
+		sql_exp *e = n->data, *pe;
+
+		if (e->type == e_aggr) {
+			sql_subaggr *a = e->f, *fa;
+			const char *aname = a->aggr->base.name;
+			sql_exp *ne;
+
+			ne = exp_aggr(sql->sa, e->l, a, 0, need_no_nil(e), CARD_AGGR, has_nil(e));
+			exp_label(sql->sa, ne, ++sql->label);
+			ne = rel_groupby_add_aggr(sql, egb, ne);
+			fa = sql_bind_aggr(sql->sa, sql->session->schema, strcmp(aname, "count") == 0 ? "sum" : aname, exp_subtype(ne));
+			if (!fa)
+				return rel;
+			ne = exp_aggr1(sql->sa, ne, fa, 0, 1, e->card, has_nil(e));
+			exp_label(sql->sa, ne, ++sql->label);
+			append(exps, ne);
+			pe = exp_ref(sql->sa, ne);
+			if (subtype_cmp(exp_subtype(pe), exp_subtype(e)) != 0)
+				pe = exp_convert(sql->sa, pe, exp_subtype(pe), exp_subtype(e));
+			if (!has_nil(e))
+				set_has_no_nil(pe);
+			exp_setname(sql->sa, pe, exp_relname(e), exp_name(e));
+		} else {
+			append(exps, e);
+			pe = exp_ref(sql->sa, e);
+		}
+		append(pexps, pe);
+	}
+	rel->exps = exps;
+	(*changes)++;
+	return rel_project(sql->sa, rel, pexps);
+}
+
 /*
  * Rewrite group(project(join(A,Dict)[a.i==dict.i])[...dict.n])[dict.n][ ... dict.n ]
  * into
@@ -7190,10 +7348,29 @@ rel_select_order(int *changes, mvc *sql, sql_rel *rel)
 	(void)sql;
 	if (is_select(rel->op) && rel->exps && list_length(rel->exps)>1) {
 		int i, *scores = calloc(list_length(rel->exps), sizeof(int));
+		int analyzed = 1;
 		node *n;
 
-		for (i = 0, n = rel->exps->h; n; i++, n = n->next) 
+		/* when all columns were analyzed, the most selective goes first */
+		for (i = 0, n = rel->exps->h; n && analyzed; i++, n = n->next) {
+			dbl sel = rel_select_exp_selectivity(sql, rel, n->data);
+
+			if (sel < 0)
+				analyzed = 0;
+			else
+				scores[i] = (int) ((1.0 - MIN(sel, 1.0)) * 1000000);
+		}
+		for (i = 0, n = rel->exps->h; n && !analyzed; i++, n = n->next) 
 			scores[i] = score_se(sql, rel, n->data);
+		/* predicates on scalars only (ie parameters) go first, as
+		 * they may empty the selection before any column is read */
+		for (i = 0, n = rel->exps->h; n; i++, n = n->next) {
+			sql_exp *e = n->data;
+
+			if (e->type == e_cmp && !is_complex_exp(e->flag) &&
+			    exp_is_atom(e->l) && exp_is_atom(e->r) && (!e->f || exp_is_atom(e->f)))
+				scores[i] = INT_MAX;
+		}
 		rel->exps = list_keysort(rel->exps, scores, (fdup)NULL);
 		free(scores);
 	}
@@ -8511,6 +8688,93 @@ rel_rename_part(mvc *sql, sql_rel *p, char *tname, sql_table *mt)
 	return p;
 }
 
+/* The bounds of partition pt of merge table t, checked against the values
+ * the selection sel compares its partition column with. These values may
+ * only be known at run time (parameters), so the checks are added to the
+ * selection on the partition itself, where they are evaluated before its
+ * columns are scanned. */
+static list *
+rel_part_guards(mvc *sql, sql_rel *rel, sql_rel *sel, sql_table *t, sql_part *pt)
+{
+	list *guards = sa_list(sql->sa), *vals = NULL;
+	sql_exp *min = NULL, *max = NULL;
+	node *n;
+
+	if (!sel || !isPartitionedByColumnTable(t))
+		return guards;
+	if (isRangePartitionTable(t)) {
+		int tpe = pt->tpe.type->localtype;
+		int (*atomcmp)(const void *, const void *) = ATOMcompare(tpe);
+		const void *nil = ATOMnilptr(tpe);
+
+		/* the nil bounds are unbounded */
+		if (atomcmp(pt->part.range.minvalue, nil) != 0)
+			min = create_table_part_atom_exp(sql, pt->tpe, pt->part.range.minvalue);
+		if (atomcmp(pt->part.range.maxvalue, nil) != 0)
+			max = create_table_part_atom_exp(sql, pt->tpe, pt->part.range.maxvalue);
+		if (!min && !max)
+			return guards;
+	} else if (isListPartitionTable(t)) {
+		if (list_empty(pt->part.values))
+			return guards;
+		vals = sa_list(sql->sa);
+		for (n = pt->part.values->h; n; n = n->next) {
+			sql_part_value *v = n->data;
+
+			append(vals, create_table_part_atom_exp(sql, v->tpe, v->value));
+		}
+	} else {
+		return guards;
+	}
+	for (n = sel->exps->h; n; n = n->next) {
+		sql_exp *e = n->data, *c, *l, *h;
+		sql_column *col;
+		sql_rel *bt = NULL;
+		int flag;
+
+		if (e->type != e_cmp || is_anti(e) || is_complex_exp(e->flag))
+			continue;
+		flag = get_cmp(e);
+		l = e->r;
+		h = e->f;
+		c = rel_find_exp(rel, e->l);
+		if (!c || c->type != e_column ||
+		    !(col = name_find_column(rel, c->l, c->r, -2, &bt)) ||
+		    col->colnr != t->part.pcol->colnr ||
+		    !exp_is_atom(l) || (h && !exp_is_atom(h)) ||
+		    exp_is_null(sql, l) || (h && exp_is_null(sql, h))) /* is (not) null */
+			continue;
+
+		if (vals) {
+			if (flag == cmp_equal && !h)
+				append(guards, exp_in(sql->sa, exp_copy(sql->sa, l), exps_copy(sql->sa, vals), cmp_in));
+			continue;
+		}
+		/* the partition holds the values from min up to (excluding) max */
+		if (h) {
+			if (flag & CMP_SYMMETRIC)
+				continue;
+			if (max)
+				append(guards, exp_compare(sql->sa, exp_copy(sql->sa, l), exp_copy(sql->sa, max), cmp_lt));
+			if (min)
+				append(guards, exp_compare(sql->sa, exp_copy(sql->sa, h), exp_copy(sql->sa, min),
+							   range2rcompare(e->flag) == cmp_lte ? cmp_gte : cmp_gt));
+		} else if (flag == cmp_equal) {
+			if (min)
+				append(guards, exp_compare(sql->sa, exp_copy(sql->sa, l), exp_copy(sql->sa, min), cmp_gte));
+			if (max)
+				append(guards, exp_compare(sql->sa, exp_copy(sql->sa, l), exp_copy(sql->sa, max), cmp_lt));
+		} else if ((flag == cmp_gt || flag == cmp_gte) && max) {
+			append(guards, exp_compare(sql->sa, exp_copy(sql->sa, l), exp_copy(sql->sa, max), cmp_lt));
+		} else if (flag == cmp_lt && min) {
+			append(guards, exp_compare(sql->sa, exp_copy(sql->sa, l), exp_copy(sql->sa, min), cmp_gt));
+		} else if (flag == cmp_lte && min) {
+			append(guards, exp_compare(sql->sa, exp_copy(sql->sa, l), exp_copy(sql->sa, min), cmp_gte));
+		}
+	}
+	return guards;
+}
+
 /* rewrite merge tables into union of base tables and call optimizer again */
 static sql_rel *
 rel_merge_table_rewrite(int *changes, mvc *sql, sql_rel *rel)
@@ -8672,6 +8936,14 @@ rel_merge_table_rewrite(int *changes, mvc *sql, sql_rel *rel)
 						}
 						prel->exps = exps;
 						first = 0;
+						if (!skip) {
+							list *guards = rel_part_guards(sql, rel, sel, t, pd);
+
+							if (!list_empty(guards)) {
+								prel = rel_select(sql->sa, prel, NULL);
+								prel->exps = guards;
+							}
+						}
 						if (!skip) {
 							append(tables, prel);
 							nrel = prel;
@@ -9088,6 +9360,8 @@ optimize_rel(mvc *sql, sql_rel *rel, int *g_changes, int level, int value_based_
 	if (gp.cnt[op_groupby]) {
 		rel = rewrite_topdown(sql, rel, &rel_push_aggr_down, &changes);
 		rel = rewrite_topdown(sql, rel, &rel_push_groupby_down, &changes);
+		if (gp.cnt[op_join])
+			rel = rewrite_topdown(sql, rel, &rel_push_aggr_eager, &changes);
 		rel = rewrite(sql, rel, &rel_groupby_order, &changes); 
 		rel = rewrite(sql, rel, &rel_reduce_groupby_exps, &changes); 
 		rel = rewrite(sql, rel, &rel_groupby_distinct, &changes); 
@@ -9189,6 +9463,307 @@ rel_reset_subquery(sql_rel *rel)
 
 }
 
+/* Sideways information passing: an equi-join of a large relation with a
+ * much smaller filtered one is marked, such that rel_bin first computes
+ * the min and max of the join key of the small (build) side and range
+ * selects the join key of the large (probe) side on those before the
+ * join. The property value lists the probe and build side key. */
+#define RANGEFILTER_MIN_ROWS 10000	/* least rows on the probe side */
+#define RANGEFILTER_RATIO 16		/* least probe rows per build row */
+
+static sql_rel *
+rel_join_rangefilter(int *changes, mvc *sql, sql_rel *rel)
+{
+	sql_rel *pr, *br;
+	lng pcnt, bcnt, brows;
+	node *n;
+
+	(void)changes;
+	if (rel->op != op_join || rel->flag || rel->single || list_empty(rel->exps) ||
+	    find_prop(rel->p, PROP_RANGEFILTER))
+		return rel;
+	for (n = rel->exps->h; n; n = n->next) {
+		sql_exp *e = n->data;
+
+		if (find_prop(e->p, PROP_HASHCOL) || find_prop(e->p, PROP_JOINIDX) ||
+		    find_prop(e->p, PROP_FETCH))
+			return rel;
+	}
+
+	pr = rel->l;
+	br = rel->r;
+	pcnt = rel_est_count(sql, pr);
+	bcnt = rel_est_count(sql, br);
+	if (pcnt < bcnt) {
+		lng cnt = pcnt;
+
+		pr = rel->r;
+		br = rel->l;
+		pcnt = bcnt;
+		bcnt = cnt;
+	}
+	/* only for a filtered build side */
+	if (pcnt < RANGEFILTER_MIN_ROWS || bcnt <= 0 ||
+	    (brows = rel_est_rows(sql, br)) < 0 || brows >= bcnt ||
+	    brows * RANGEFILTER_RATIO > pcnt)
+		return rel;
+
+	for (n = rel->exps->h; n; n = n->next) {
+		sql_exp *e = n->data, *pe = NULL, *ke = NULL;
+		int ec;
+
+		if (e->type != e_cmp || get_cmp(e) != cmp_equal || is_anti(e))
+			continue;
+		ec = exp_subtype(e->l)->type->eclass;
+		if (!(EC_NUMBER(ec) || EC_TEMP(ec)))
+			continue;
+		if (rel_find_exp(pr, e->l) && rel_find_exp(br, e->r)) {
+			pe = e->l;
+			ke = e->r;
+		} else if (rel_find_exp(pr, e->r) && rel_find_exp(br, e->l)) {
+			pe = e->r;
+			ke = e->l;
+		}
+		if (pe && pe->type == e_column) {
+			list *keys = sa_list(sql->sa);
+
+			append(keys, pe);
+			append(keys, ke);
+			rel->p = prop_create(sql->sa, PROP_RANGEFILTER, rel->p);
+			((prop *) rel->p)->value = keys;
+			return rel;
+		}
+	}
+	return rel;
+}
+
+/* Common subplan sharing: structurally identical subtrees (eg repeated
+ * subqueries in union branches) are replaced by a reference to the first
+ * one, such that rel_bin computes them only once. Expression names have
+ * to match as well, as the parents refer to the subtree by name, except
+ * for the outputs of the top relation, which may differ in their (label)
+ * names only, these are renamed by a projection on top of the reference. */
+static int
+name_same(const char *n1, const char *n2)
+{
+	return n1 == n2 || (n1 && n2 && strcmp(n1, n2) == 0);
+}
+
+static int exps_same(list *l, list *r, int names);
+
+static int
+exp_same(sql_exp *e1, sql_exp *e2, int names)
+{
+	if (e1 == e2)
+		return 1;
+	if (!e1 || !e2 || e1->type != e2->type || e1->flag != e2->flag ||
+	    e1->card != e2->card || is_anti(e1) != is_anti(e2) ||
+	    (names && (!name_same(exp_relname(e1), exp_relname(e2)) ||
+	    !name_same(exp_name(e1), exp_name(e2)))))
+		return 0;
+
+	switch(e1->type) {
+	case e_column:
+		return name_same(e1->l, e2->l) && name_same(e1->r, e2->r);
+	case e_atom:
+		/* only literals, parameters and variables may change */
+		return e1->l && e2->l && !atom_cmp(e1->l, e2->l) &&
+			!subtype_cmp(exp_subtype(e1), exp_subtype(e2));
+	case e_convert:
+		return !subtype_cmp(exp_totype(e1), exp_totype(e2)) &&
+			!subtype_cmp(exp_fromtype(e1), exp_fromtype(e2)) &&
+			exp_same(e1->l, e2->l, 1);
+	case e_func: {
+		sql_subfunc *f = e1->f;
+
+		return !f->func->side_effect && !subfunc_cmp(e1->f, e2->f) &&
+			exps_same(e1->l, e2->l, 1) && exps_same(e1->r, e2->r, 1);
+	}
+	case e_aggr:
+		return !subaggr_cmp(e1->f, e2->f) && exps_same(e1->l, e2->l, 1);
+	case e_cmp:
+		if (get_cmp(e1) == cmp_or || get_cmp(e1) == cmp_filter)
+			return exps_same(e1->l, e2->l, 1) && exps_same(e1->r, e2->r, 1) &&
+				(get_cmp(e1) == cmp_or || !subfunc_cmp(e1->f, e2->f));
+		if (e1->flag == cmp_in || e1->flag == cmp_notin)
+			return exp_same(e1->l, e2->l, 1) && exps_same(e1->r, e2->r, 1);
+		return exp_same(e1->l, e2->l, 1) && exp_same(e1->r, e2->r, 1) &&
+			exp_same(e1->f, e2->f, 1);
+	default:
+		return 0;
+	}
+}
+
+static int
+exps_same(list *l, list *r, int names)
+{
+	node *n, *m;
+
+	if (list_length(l) != list_length(r))
+		return 0;
+	if (!l || !r)
+		return 1;
+	for (n = l->h, m = r->h; n && m; n = n->next, m = m->next)
+		if (!exp_same(n->data, m->data, names))
+			return 0;
+	return 1;
+}
+
+static int
+rel_same(sql_rel *l, sql_rel *r, int names)
+{
+	if (l == r)
+		return 1;
+	if (!l || !r || l->op != r->op || l->flag != r->flag ||
+	    l->card != r->card || l->nrcols != r->nrcols ||
+	    l->single != r->single || l->dependent != r->dependent ||
+	    !exps_same(l->exps, r->exps, names))
+		return 0;
+
+	switch(l->op) {
+	case op_basetable:
+		return l->l == r->l;
+	case op_project:
+	case op_groupby:
+		return exps_same(l->r, r->r, 1) && rel_same(l->l, r->l, 1);
+	case op_select:
+	case op_topn:
+		return rel_same(l->l, r->l, 1);
+	case op_join:
+	case op_left:
+	case op_right:
+	case op_full:
+	case op_semi:
+	case op_anti:
+	case op_union:
+	case op_inter:
+	case op_except:
+		return rel_same(l->l, r->l, 1) && rel_same(l->r, r->r, 1);
+	default: /* table functions, samples and updates may differ */
+		return 0;
+	}
+}
+
+/* sharing a plain (projected) table scan gains nothing */
+static int
+rel_has_work(sql_rel *rel)
+{
+	if (!rel)
+		return 0;
+	switch(rel->op) {
+	case op_project:
+		return rel->r || rel_has_work(rel->l);
+	case op_basetable:
+	case op_table:
+	case op_sample:
+	case op_ddl:
+		return 0;
+	default:
+		return !is_modify(rel->op);
+	}
+}
+
+/* a structural key of (at most the first budget nodes of) rel, equal for
+ * subtrees which may be the same */
+static unsigned int
+rel_share_key(sql_rel *rel, int *budget)
+{
+	unsigned int key;
+
+	if (!rel || *budget <= 0)
+		return 0;
+	(*budget)--;
+	key = (rel->op << 24) ^ (rel->flag << 16) ^ (rel->nrcols << 8) ^ list_length(rel->exps);
+	if (rel->op == op_basetable && rel->l)
+		return key ^ hash_key(((sql_table *) rel->l)->base.name);
+	if (is_modify(rel->op) || rel->op == op_table || rel->op == op_ddl)
+		return key;
+	key = key * 31 + rel_share_key(rel->l, budget);
+	if (is_join(rel->op) || is_semi(rel->op) || is_set(rel->op))
+		key = key * 31 + rel_share_key(rel->r, budget);
+	return key;
+}
+
+#define SHARE_KEY_BUDGET 1024
+
+static void
+rel_share_subplans_(mvc *sql, sql_rel **rp, sql_hash *seen)
+{
+	sql_rel *rel = *rp;
+	sql_hash_e *he;
+	int key = 0, budget = SHARE_KEY_BUDGET;
+
+	if (!rel || THRhighwater())
+		return;
+	if (rel_has_work(rel)) {
+		key = (int) rel_share_key(rel, &budget);
+		if (rel_is_ref(rel))
+			for (he = seen->buckets[key & (seen->size - 1)]; he; he = he->chain)
+				if (he->value == rel)
+					return;
+
+		for (he = seen->buckets[key & (seen->size - 1)]; he; he = he->chain) {
+			sql_rel *s = he->value;
+
+			if (he->key == key && rel_same(s, rel, 0)) {
+				*rp = rel_dup(s);
+				if (is_project(rel->op) && !exps_same(s->exps, rel->exps, 1)) {
+					list *exps = new_exp_list(sql->sa);
+					node *m, *n;
+
+					for (m = s->exps->h, n = rel->exps->h; m && n; m = m->next, n = n->next) {
+						sql_exp *e = m->data, *ne = exp_ref(sql->sa, e);
+
+						exp_prop_alias(ne, n->data);
+						append(exps, ne);
+					}
+					*rp = rel_project(sql->sa, *rp, exps);
+				}
+				rel_destroy(rel);
+				return;
+			}
+		}
+		hash_add(seen, key, rel);
+	}
+
+	switch(rel->op) {
+	case op_select:
+	case op_topn:
+	case op_sample:
+	case op_project:
+	case op_groupby:
+		rel_share_subplans_(sql, (sql_rel**)&rel->l, seen);
+		break;
+	case op_join:
+	case op_left:
+	case op_right:
+	case op_full:
+	case op_semi:
+	case op_anti:
+	case op_union:
+	case op_inter:
+	case op_except:
+		rel_share_subplans_(sql, (sql_rel**)&rel->l, seen);
+		rel_share_subplans_(sql, (sql_rel**)&rel->r, seen);
+		break;
+	case op_insert:
+	case op_update:
+	case op_delete:
+		/* only within the input of a single statement */
+		rel_share_subplans_(sql, (sql_rel**)&rel->r, seen);
+		break;
+	default:
+		break;
+	}
+}
+
+static sql_rel *
+rel_share_subplans(mvc *sql, sql_rel *rel)
+{
+	rel_share_subplans_(sql, &rel, hash_new(sql->sa, 1024, NULL));
+	return rel;
+}
+
 static sql_rel *
 optimize(mvc *sql, sql_rel *rel, int value_based_opt) 
 {
@@ -9207,6 +9782,8 @@ optimize(mvc *sql, sql_rel *rel, int value_based_opt)
 		for (n = refs->h; n; n = n->next)
 			n->data = optimize_rel(sql, n->data, &changes, 0, value_based_opt);
 	}
+	rel = rel_share_subplans(sql, rel);
+	rel = rewrite(sql, rel, &rel_join_rangefilter, &changes);
 	rel = rel_dce(sql, rel);
 	return rel;
 }
@@ -6,163 +6,67 @@
  * Copyright 1997 - July 2008 CWI, August 2008 - 2019 MonetDB B.V.
  */
 
+/*
+ * The join planner orders the relations of an inner join on their
+ * estimated sizes. The size of a base table is taken from the storage,
+ * the selectivity of the selections and join predicates from the column
+ * statistics (sys.statistics), i.e. the number of distinct values and
+ * the value ranges.
+ *
+ * For up to PLANNER_DP relations all connected sub sets of relations are
+ * enumerated bottom up (dynamic programming), keeping the cheapest join
+ * tree for each of them. The cost of a tree is the sum of the sizes of
+ * its intermediate results. Larger joins are planned greedily, by
+ * repeatedly joining the pair of trees with the smallest result.
+ * Relations which are not connected by a join predicate are combined
+ * with a cross product at the end, smallest first.
+ *
+ * For the columns analyzed by ANALYZE, the selectivities are taken from
+ * their histograms, most common values and distinct value sketches.
+ */
 #include "monetdb_config.h"
 #include "rel_planner.h"
 #include "rel_rel.h"
 #include "rel_exp.h"
 #include "rel_prop.h"
 #include "rel_optimizer.h"
+#include "store_stats.h"
 
-typedef struct memoitem {
-	const char *name;
-	list *rels;
-	list *exps;
-	list *joins;
-	int done;
-	int level;
-	lng count;
-	lng width;
-	dbl cost;
-	void *data;
-} memoitem;
-
-#define p_pkey 1
-#define p_fkey 2
-#define p_ukey 3
-
-typedef struct memojoin {
-	memoitem *l, *r;
-	int rules; 	/* handled rules */
-	int prop; 	/* pkey, fkey, ukey */
-	dbl cost;
-	dbl sel;
-	sql_exp *e;
-} memojoin;
-
-static int
-memoitem_key( memoitem *mi )
-{
-	return hash_key(mi->name);
-}
-
-static memoitem*
-memo_find(list *memo, const char *name)
-{
-	int key = hash_key(name);
-	sql_hash_e *he;
-
-	MT_lock_set(&memo->ht_lock);
-	he = memo->ht->buckets[key&(memo->ht->size-1)]; 
-	for (; he; he = he->chain) {
-		memoitem *mi = he->value;
-
-		if (mi->name && strcmp(mi->name, name) == 0) {
-			MT_lock_unset(&memo->ht_lock);
-			return mi;
-		}
-	}
-	MT_lock_unset(&memo->ht_lock);
-	return NULL;
-}
-
-static char *
-merge_names( sql_allocator *sa, const char *lname, const char *rname)
-{
-	size_t l = strlen(lname) + strlen(rname) + 2;
-	char *n = SA_NEW_ARRAY(sa, char, l);
-	const char *p = lname;
-	const char *c;
-
-	while ((c = strchr(p, ',')) != NULL) {
-		if (strncmp(p, rname, c - p) > 0) {
-			if (p > lname)
-				snprintf(n, l, "%.*s,%s,%s", (int) (c - lname),
-					 lname, rname, c + 1);
-			else
-				snprintf(n, l, "%s,%s", rname, lname);
-			return n;
-		}
-		p = c + 1;
-	}
-	snprintf(n, l, "%s,%s", lname, rname);
-	return n;
-}
-
-static memoitem *
-memoitem_create( list *memo, sql_allocator *sa, const char *lname, const char *rname, int level)
-{
-	const char *name = lname;
-	memoitem *mi;
-
-	if (level > 1) 
-		name = merge_names(sa, lname, rname);
-	if (memo_find(memo, name))
-		return NULL;
-       	mi = SA_NEW(sa, memoitem); 
-	mi->name = sa_strdup(sa, name);
-	mi->joins = (rname)?sa_list(sa):NULL;
-	mi->done = (rname)?0:1;
-	mi->level = level;
-	mi->count = 1;
-	mi->cost = 0;
-	mi->width = 8;
-	mi->data = NULL;
-	mi->rels = sa_list(sa);
-	mi->exps = sa_list(sa);
-	list_append(memo, mi);
-	return mi;
-}
+#define PLANNER_DP	12	/* largest join planned exhaustively */
 
+/* the number of tuples of a relation, or -1 if unknown */
 static lng
 rel_getcount(mvc *sql, sql_rel *rel)
 {
 	if (!sql->session->tr)
-		return 0;
+		return -1;
 
 	switch(rel->op) {
 	case op_basetable: {
 		sql_table *t = rel->l;
 
-		if (t && isTable(t))
+		if (t && isTable(t) && t->persistence != SQL_DECLARED_TABLE)
 			return (lng)store_funcs.count_col(sql->session->tr, t->columns.set->h->data, 1);
 		if (!t && rel->r) /* dict */
 			return (lng)sql_trans_dist_count(sql->session->tr, rel->r);
-		return 0;
+		return -1;
 	}
 	case op_select:
 	case op_project:
+	case op_semi:
+	case op_anti:
+	case op_topn:
 		if (rel->l)
 			return rel_getcount(sql, rel->l);
 		return 1;
-	default:
-		return 0;
-	}
-}
-
-static lng
-rel_getwidth(mvc *sql, sql_rel *rel)
-{
-	if (!sql->session->tr)
-		return 0;
-
-	switch(rel->op) {
-	case op_basetable: {
-		sql_table *t = rel->l;
-
-		if (t && isTable(t))
-			return 4*list_length(rel->exps);
-		return 0;
-	}	
-	case op_select:
+	case op_groupby:
+		if (!rel->r || list_empty(rel->r))
+			return 1;
 		if (rel->l)
-			return rel_getwidth(sql, rel->l);
-		return 1;
-	case op_project:
-		if (rel->l)
-			return 4*list_length(rel->exps);
+			return rel_getcount(sql, rel->l);
 		return 1;
 	default:
-		return 0;
+		return -1;
 	}
 }
 
@@ -175,15 +79,21 @@ exp_getdcount( mvc *sql, sql_rel *r , sql_exp *e, lng count)
 		sql_rel *bt = NULL;
 		sql_column *c = name_find_column(r, e->l, e->r, -1, &bt);
 		if (c) {
-			lng dcount = (lng)sql_trans_dist_count(sql->session->tr, c);
+			sql_colstats s;
+			lng dcount;
+
+			if (stats_get(c, &s) && s.ndv > 0)
+				dcount = MAX((lng) s.ndv, 1);
+			else
+				dcount = (lng)sql_trans_dist_count(sql->session->tr, c);
 			if (dcount != 0 && dcount < count)
 				return dcount;
 		}
 		return count;
-	} 
+	}
 	case e_cmp:
 		assert(0);
-	
+
 
 	case e_convert:
 		if (e->l)
@@ -198,6 +108,24 @@ exp_getdcount( mvc *sql, sql_rel *r , sql_exp *e, lng count)
 	return count;
 }
 
+/* the estimated number of tuples of rel, -1 if unknown */
+lng
+rel_est_count(mvc *sql, sql_rel *rel)
+{
+	return rel_getcount(sql, rel);
+}
+
+/* the estimated number of distinct values of e in rel, -1 if unknown */
+lng
+rel_est_distinct(mvc *sql, sql_rel *rel, sql_exp *e)
+{
+	lng count = rel_getcount(sql, rel);
+
+	if (count < 0)
+		return -1;
+	return exp_getdcount(sql, rel, e, count);
+}
+
 static int
 exp_getranges( mvc *sql, sql_rel *r , sql_exp *e, char **min, char **max)
 {
@@ -206,10 +134,10 @@ exp_getranges( mvc *sql, sql_rel *r , sql_exp *e, char **min, char **max)
 		/* find col */
 		sql_rel *bt = NULL;
 		sql_column *c = name_find_column(r, e->l, e->r, -1, &bt);
-		if (c) 
+		if (c)
 			return sql_trans_ranges(sql->session->tr, c, min, max);
 		return 0;
-	} 
+	}
 	case e_cmp:
 		assert(0);
 
@@ -227,7 +155,7 @@ exp_getranges( mvc *sql, sql_rel *r , sql_exp *e, char **min, char **max)
 }
 
 static atom *
-exp_getatom( mvc *sql, sql_exp *e, atom *m) 
+exp_getatom( mvc *sql, sql_exp *e, atom *m)
 {
 	if (is_atom(e->type))
 		return exp_value(sql, e, sql->args, sql->argc);
@@ -250,39 +178,153 @@ exp_getatom( mvc *sql, sql_exp *e, atom *m)
 	return m;
 }
 
+/* the value of a numeric or temporal atom on a linear scale */
+static int
+atom_getdbl(atom *a, dbl *d)
+{
+	if (!a || a->isnull)
+		return 0;
+	switch (ATOMstorage(a->data.vtype)) {
+	case TYPE_bte:
+		*d = a->data.val.btval;
+		break;
+	case TYPE_sht:
+		*d = a->data.val.shval;
+		break;
+	case TYPE_int:
+		*d = a->data.val.ival;
+		break;
+	case TYPE_lng:
+		*d = (dbl) a->data.val.lval;
+		break;
+#ifdef HAVE_HGE
+	case TYPE_hge:
+		*d = (dbl) a->data.val.hval;
+		break;
+#endif
+	case TYPE_flt:
+		*d = a->data.val.fval;
+		break;
+	case TYPE_dbl:
+		*d = a->data.val.dval;
+		break;
+	default:
+		return 0;
+	}
+	return 1;
+}
+
 static dbl
 exp_getrange_sel( mvc *sql, sql_rel *r, sql_exp *e, char *min, char *max)
 {
 	atom *amin, *amax, *emin, *emax;
-	dbl sel = 1.0;
+	dbl lo, hi, elo, ehi;
 	sql_subtype *t = exp_subtype(e->l);
 
 	(void)r;
 	emin = amin = atom_general(sql->sa, t, min);
 	emax = amax = atom_general(sql->sa, t, max);
 
-	if (e->f || e->flag == cmp_gt || e->flag == cmp_gte) 
+	if (e->f || e->flag == cmp_gt || e->flag == cmp_gte)
 		emin = exp_getatom(sql, e->r, amin);
-	if (e->f || e->flag == cmp_lt || e->flag == cmp_lte) 
+	if (e->f || e->flag == cmp_lt || e->flag == cmp_lte)
 		emax = (e->f)?exp_getatom(sql, e->f, amax):
 			exp_getatom(sql, e->r, amax);
 
-	if (!amin || !amax)
+	if (!atom_getdbl(amin, &lo) || !atom_getdbl(amax, &hi) || hi <= lo)
 		return 0.1;
+	if (!atom_getdbl(emin, &elo) || !atom_getdbl(emax, &ehi) ||
+		/* the constants should be on the scale of the column */
+		emin->tpe.scale != t->scale || emax->tpe.scale != t->scale)
+		return 0.125;
+	return (MIN(ehi, hi) - MAX(elo, lo)) / (hi - lo);
+}
+
+/* the distribution of the column of e, if it was analyzed */
+static int
+exp_getstats(sql_rel *r, sql_exp *e, sql_colstats *s)
+{
+	sql_rel *bt = NULL;
+	sql_column *c;
+
+	if (e->type != e_column)
+		return 0;
+	c = name_find_column(r, e->l, e->r, -1, &bt);
+	return c && stats_get(c, s);
+}
+
+/* the value of the constant e, on the scale of the column col */
+static int
+exp_getvalue(mvc *sql, sql_exp *col, sql_exp *e, dbl *d)
+{
+	atom *a = exp_getatom(sql, e, NULL);
+
+	return atom_getdbl(a, d) && a->tpe.scale == exp_subtype(col)->scale;
+}
+
+static dbl
+stats_value_selectivity(mvc *sql, sql_colstats *s, sql_exp *col, sql_exp *e)
+{
+	dbl v;
+
+	if (exp_getvalue(sql, col, e, &v))
+		return stats_eq_selectivity(s, v);
+	/* values without a numeric scale, or not known yet */
+	return s->count > s->nils ?
+		(dbl) (s->count - s->nils) / s->count / MAX(s->ndv, 1.0) : 0;
+}
 
-	if (!emin || !emax)
-		sel = 0.125;
-	/* 4 case, dbl and lng, date, timestamp */
-	else if (t->type->eclass == EC_DATE) {
-		sel = (emax->data.val.ival-emin->data.val.ival)/(dbl)(amax->data.val.ival-amin->data.val.ival);
-	} else if (t->type->eclass == EC_TIMESTAMP) {
-		sel = (emax->data.val.lval-emin->data.val.lval)/(dbl)(amax->data.val.lval-amin->data.val.lval);
-	} else if (t->type->eclass == EC_FLT) {
-		sel = (emax->data.val.dval-emin->data.val.dval)/(amax->data.val.dval-amin->data.val.dval);
-	} else { /* lng */
-		sel = (emax->data.val.lval-emin->data.val.lval)/(dbl)(amax->data.val.lval-amin->data.val.lval);
+/* The selectivity of the selection e, based on the distribution of
+ * its column, or -1 if that was not analyzed */
+static dbl
+rel_exp_stats_selectivity(mvc *sql, sql_rel *r, sql_exp *e)
+{
+	sql_colstats s;
+	dbl sel, nonnil, lo = -GDK_dbl_max, hi = GDK_dbl_max;
+	node *n;
+
+	if (e->type != e_cmp || is_anti(e) || !exp_getstats(r, e->l, &s))
+		return -1;
+	nonnil = s.count > 0 ? (dbl) (s.count - s.nils) / s.count : 1.0;
+	switch (get_cmp(e)) {
+	case cmp_equal:
+		return stats_value_selectivity(sql, &s, e->l, e->r);
+	case cmp_notequal:
+		return nonnil - stats_value_selectivity(sql, &s, e->l, e->r);
+	case cmp_gt:
+	case cmp_gte:
+	case cmp_lt:
+	case cmp_lte:
+		if (e->f) {	/* range */
+			if (!exp_getvalue(sql, e->l, e->r, &lo) ||
+			    !exp_getvalue(sql, e->l, e->f, &hi))
+				return -1;
+		} else if (get_cmp(e) == cmp_gt || get_cmp(e) == cmp_gte) {
+			if (!exp_getvalue(sql, e->l, e->r, &lo))
+				return -1;
+		} else if (!exp_getvalue(sql, e->l, e->r, &hi)) {
+			return -1;
+		}
+		return stats_range_selectivity(&s, lo, hi);
+	case cmp_in:
+	case cmp_notin:
+		sel = 0;
+		for (n = ((list *) e->r)->h; n; n = n->next)
+			sel += stats_value_selectivity(sql, &s, e->l, n->data);
+		if (get_cmp(e) == cmp_notin)
+			sel = nonnil - sel;
+		return MAX(sel, 0);
+	default:
+		return -1;
 	}
-	return sel;
+}
+
+dbl
+rel_select_exp_selectivity(mvc *sql, sql_rel *rel, sql_exp *e)
+{
+	if (!sql->session->tr)
+		return -1;
+	return rel_exp_stats_selectivity(sql, rel, e);
 }
 
 static dbl
@@ -294,7 +336,17 @@ rel_exp_selectivity(mvc *sql, sql_rel *r, sql_exp *e, lng count)
 		return 1.0;
 	switch(e->type) {
 	case e_cmp: {
-		lng dcount = exp_getdcount( sql, r, e->l, count);
+		lng dcount;
+
+		if ((sel = rel_exp_stats_selectivity(sql, r, e)) >= 0)
+			break;
+		sel = 1.0;
+		if (get_cmp(e) == cmp_or || get_cmp(e) == cmp_filter)
+			dcount = count;
+		else
+			dcount = exp_getdcount( sql, r, e->l, count);
+		if (dcount <= 0)
+			dcount = 1;
 
 		switch (get_cmp(e)) {
 		case cmp_equal: {
@@ -320,10 +372,12 @@ rel_exp_selectivity(mvc *sql, sql_rel *r, sql_exp *e, lng count)
 		case cmp_filter:
 			sel = 0.01;
 			break;
-		case cmp_in: 
+		case cmp_in:
 		case cmp_notin: {
 			list *l = e->r;
 			sel = (dbl) list_length(l) / dcount;
+			if (get_cmp(e) == cmp_notin)
+				sel = 1.0 - sel;
 			break;
 		}
 		case cmp_or:
@@ -337,73 +391,22 @@ rel_exp_selectivity(mvc *sql, sql_rel *r, sql_exp *e, lng count)
 	default:
 		break;
 	}
+	/* the estimates are rough, don't rule out any tuples */
+	if (!(sel >= 0.0001))
+		sel = 0.0001;
+	if (sel > 1.0)
+		sel = 1.0;
 	return sel;
 }
 
 static dbl
-rel_join_exp_selectivity(mvc *sql, sql_rel *l, sql_rel *r, sql_exp *e, lng lcount, lng rcount)
-{
-	dbl sel = 1.0;
-	lng ldcount, rdcount;
-
-	if (!e)
-		return 1.0;
-	assert(lcount);
-	assert(rcount);
-	ldcount = exp_getdcount(sql, l, e->l, lcount);
-	rdcount = exp_getdcount(sql, r, e->r, rcount);
-	switch(e->type) {
-	case e_cmp:
-		switch (get_cmp(e)) {
-		case cmp_equal: 
-			sel = (lcount/(dbl)ldcount)*(rcount/(dbl)rdcount);
-			break;
-		case cmp_notequal: {
-			dbl cnt = (lcount/(dbl)ldcount)*(rcount/(dbl)rdcount);
-			sel = (cnt-1)/cnt;
-		}	break;
-		case cmp_gt:
-		case cmp_gte:
-		case cmp_lt:
-		case cmp_lte:
-			/* ugh */
-			sel = 0.5;
-			if (e->f) /* range */
-				sel = 0.2;
-			break;
-		case cmp_filter:
-			sel = 0.1;
-			break;
-		case cmp_in: 
-		case cmp_notin: {
-			lng cnt = lcount*rcount;
-			list *l = e->r;
-			sel = (dbl) list_length(l) / cnt;
-			break;
-		}
-		case cmp_or:
-			sel = 0.5;
-			break;
-		default:
-			return 1.0;
-		}
-		break;
-	default:
-		break;
-	}
-	assert(sel >= 0.000001);
-	return sel;
-}
-
-
-static dbl
-rel_exps_selectivity(mvc *sql, sql_rel *rel, list *exps, lng count) 
+rel_exps_selectivity(mvc *sql, sql_rel *rel, list *exps, lng count)
 {
 	node *n;
 	dbl sel = 1.0;
 	if (!exps->h)
 		return 1.0;
-	for(n=exps->h; n; n = n->next) { 
+	for(n=exps->h; n; n = n->next) {
 		dbl nsel = rel_exp_selectivity(sql, rel, n->data, count);
 
 		sel *= nsel;
@@ -412,7 +415,7 @@ rel_exps_selectivity(mvc *sql, sql_rel *rel, list *exps, lng count)
 }
 
 /* need real values, ie
- * point select on pkey -> 1 value -> selectivity count 
+ * point select on pkey -> 1 value -> selectivity count
  */
 
 static dbl
@@ -423,7 +426,10 @@ rel_getsel(mvc *sql, sql_rel *rel, lng count)
 
 	switch(rel->op) {
 	case op_select:
-		return rel_exps_selectivity(sql, rel, rel->exps, count);
+		if (rel->l && rel->exps)
+			return rel_exps_selectivity(sql, rel, rel->exps, count) *
+				rel_getsel(sql, rel->l, count);
+		return 1.0;
 	case op_project:
 		if (rel->l)
 			return rel_getsel(sql, rel->l, count);
@@ -433,530 +439,371 @@ rel_getsel(mvc *sql, sql_rel *rel, lng count)
 	}
 }
 
-static list*
-memo_create(mvc *sql, list *rels )
+/* the estimated number of rows of rel after its selections, -1 if unknown */
+lng
+rel_est_rows(mvc *sql, sql_rel *rel)
 {
-	int len = list_length(rels);
-	list *memo = sa_list(sql->sa);
-	node *n;
+	lng count = rel_getcount(sql, rel);
 
-	MT_lock_set(&memo->ht_lock);
-	memo->ht = hash_new(sql->sa, len*len, (fkeyvalue)&memoitem_key);
-	MT_lock_unset(&memo->ht_lock);
-	for(n = rels->h; n; n = n->next) {
-		sql_rel *r = n->data;
-		memoitem *mi = memoitem_create(memo, sql->sa, rel_name(r), NULL, 1);
-		dbl sel = 1;
-
-		mi->count = rel_getcount(sql, r);
-		sel = rel_getsel(sql, r, mi->count);
-		mi->count = MAX( (lng) (mi->count*sel), 1);
-		assert(mi->count);
-		mi->width = rel_getwidth(sql, r);
-		mi->cost = (dbl)(mi->count*mi->width);
-		mi->data = r;
-		append(mi->rels, r);
-	}
-	return memo;
+	if (count < 0)
+		return -1;
+	return (lng) (count * rel_getsel(sql, rel, count));
 }
 
-static void
-memo_add_exps(list *memo, mvc *sql, list *rels, list *jes)
+/* The selectivity of a join predicate between relations l and r, i.e.
+ * the fraction of their cross product it returns. For equi-joins the
+ * values of the side with the fewest distinct values are assumed to
+ * be contained in the other side. */
+static dbl
+rel_join_exp_selectivity(mvc *sql, sql_rel *l, sql_rel *r, sql_exp *e, lng lcount, lng rcount)
 {
-	node *n;
-	memoitem *mi;
+	dbl sel = 1.0;
+	lng ldcount, rdcount;
 
-	for(n = jes->h; n; n = n->next) {
-		sql_exp *e = n->data;
-		if (e->type != e_cmp || !is_complex_exp(e->flag)){
-			sql_rel *l = find_one_rel(rels, e->l);
-			sql_rel *r = find_one_rel(rels, e->r);
-			memojoin *mj = SA_ZNEW(sql->sa, memojoin);
-
-			mj->l = memo_find( memo, rel_name(l));
-			mj->r = memo_find( memo, rel_name(r));
-			mj->rules = 0;
-			mj->cost = 0;
-			mj->e = e;
-			mj->sel = rel_join_exp_selectivity(sql, l, r, e, mj->l->count, mj->r->count);
-
-			mi = memoitem_create(memo, sql->sa, mj->l->name, mj->r->name, 2);
-			mi->width = (rel_getwidth(sql, l) + rel_getwidth(sql, r))/2;
-			mi->data = e;
-			mi->count = (lng)(mj->sel * MIN(mj->l->count, mj->r->count));
-			append(mi->rels, l);
-			append(mi->rels, r);
-			append(mi->exps, e);
-			list_append(mi->joins, mj);
-		}
+	ldcount = exp_getdcount(sql, l, e->l, lcount);
+	rdcount = exp_getdcount(sql, r, e->r, rcount);
+	switch (get_cmp(e)) {
+	case cmp_equal:
+		sel = 1.0 / MAX(MAX(ldcount, rdcount), 1);
+		break;
+	case cmp_notequal:
+		sel = 1.0 - 1.0 / MAX(MAX(ldcount, rdcount), 1);
+		break;
+	case cmp_gt:
+	case cmp_gte:
+	case cmp_lt:
+	case cmp_lte:
+		/* ugh */
+		sel = 0.5;
+		if (e->f) /* range */
+			sel = 0.2;
+		break;
+	default:
+		sel = 1.0;
 	}
+	if (!(sel >= 1e-12))
+		sel = 1e-12;
+	return sel;
 }
 
-static int
-memoitem_has( memoitem *mi, const char *name)
-{
-	if (mi->level > 1) {
-		memojoin *mj = mi->joins->h->data; 
+typedef struct planner {
+	mvc *sql;
+	int nrels;
+	sql_rel **rels;
+	dbl *card;		/* the estimated size of the relations */
+	int nedges;
+	int *el, *er;		/* the relations connected by a join predicate */
+	dbl *sel;		/* and its selectivity */
+} planner;
 
-		return (memoitem_has(mj->l, name) ||
-		        memoitem_has(mj->r, name)); 
-	} else {
-		return strcmp(mi->name, name) == 0;
-	}
-}
+typedef struct plantree {
+	sql_rel *rel;
+	dbl card;
+} plantree;
 
-static void
-memoitem_add_attr(list *memo, mvc *sql, memoitem *mi, list *rels, list *jes, int level)
+static int
+planner_find(planner *p, sql_rel *r)
 {
-	node *n;
-
-	for( n = jes->h; n; n = n->next) {
-		sql_exp *e = n->data;
+	int i;
 
-		if (e->type != e_cmp || !is_complex_exp(e->flag)){
-			int hasl = 0, hasr = 0;
-			sql_rel *l = find_one_rel(rels, e->l);
-			sql_rel *r = find_one_rel(rels, e->r);
-
-			/* check if exactly one rel is in mi */
-			hasl = memoitem_has(mi, rel_name(l));
-			hasr = memoitem_has(mi, rel_name(r));
-			if (hasl != hasr) {
-				memoitem *nmi;
-				sql_rel *rr = r;
-
-				if (!hasl)
-					rr = l;
-				nmi = memoitem_create(memo, sql->sa, mi->name, rel_name(rr), level);
-				if (nmi) {
-					memojoin *mj = SA_ZNEW(sql->sa, memojoin);
-					lng mincnt = 0;
-
-					list_merge(nmi->rels, mi->rels, (fdup)NULL);
-					append(nmi->rels, rr);
-					append(nmi->exps, e);
-
-					mj->l = mi;
-					mj->r = memo_find( memo, rel_name(rr));
-				       	mincnt = MIN(mj->l->count, mj->r->count);
-					nmi->width = mi->width + mj->r->width;
-					mj->rules = 0;
-					mj->cost = 0;
-					mj->sel = rel_join_exp_selectivity(sql, l, r, e, mj->l->count, mj->r->count);
-					list_append(nmi->joins, mj);
-
-					if (!nmi->count)
-						nmi->count = (lng)(mincnt*mj->sel);
-					nmi->count = MIN((lng) (mincnt*mj->sel), nmi->count);
-					assert(nmi->count >= 0);
-				}
-			}
-		}
-	}
+	for (i = 0; i < p->nrels; i++)
+		if (p->rels[i] == r)
+			return i;
+	return -1;
 }
 
-static void
-memo_add_attr(list *memo, mvc *sql, list *rels, list *jes)
+static planner *
+planner_create(mvc *sql, list *rels, list *djes)
 {
+	planner *p = SA_ZNEW(sql->sa, planner);
+	int i, nexps = list_length(djes);
 	node *n;
-	int l, len = list_length(rels);
 
-	for(l=2; l<len; l++) {
-		for (n = memo->h; n; n = n->next) {
-			memoitem *mi = n->data;
+	p->sql = sql;
+	p->nrels = list_length(rels);
+	p->rels = SA_NEW_ARRAY(sql->sa, sql_rel*, p->nrels);
+	p->card = SA_NEW_ARRAY(sql->sa, dbl, p->nrels);
+	p->el = SA_NEW_ARRAY(sql->sa, int, nexps);
+	p->er = SA_NEW_ARRAY(sql->sa, int, nexps);
+	p->sel = SA_NEW_ARRAY(sql->sa, dbl, nexps);
+	for (n = rels->h, i = 0; n; n = n->next, i++) {
+		sql_rel *r = n->data;
+		lng cnt = rel_getcount(sql, r);
 
-			if (mi->level == l) 
-				memoitem_add_attr( memo, sql, mi, rels, jes, l+1);
-		}
+		/* without an estimate, the order of the relations is kept */
+		if (cnt < 0)
+			return NULL;
+		p->rels[i] = r;
+		p->card[i] = MAX(cnt * rel_getsel(sql, r, cnt), 1.0);
 	}
-}
-
-/* Rule 1: Commutativity A join B -> B join A */
-static int 
-memoitem_apply_r1(memoitem *mi, sql_allocator *sa)
-{
-	int changes = 0;
-	node *n;
-
-	if (!mi->joins)
-		return 0;
-	for ( n = mi->joins->h; n; n = n->next) {
-		memojoin *mj = n->data;
-
-		if (mj->rules == 0 || mj->rules == 2) {
-			memojoin *mjn = SA_ZNEW(sa, memojoin);
-
-			mjn->l = mj->r;
-			mjn->r = mj->l;
-
-			if (mj->rules)
-				mj->rules = 4;
-			else
-				mj->rules = 1;
-			mjn->rules = 4;
-			mjn->cost = 0;
-			mjn->sel = mj->sel;
-			list_append(mi->joins, mjn);
-			changes ++;
-		}
+	for (n = djes->h; n; n = n->next) {
+		sql_exp *e = n->data;
+		sql_rel *l, *r;
+		int li, ri;
+
+		if (e->type != e_cmp || is_complex_exp(e->flag) || e->f)
+			continue;
+		l = find_one_rel(rels, e->l);
+		r = find_one_rel(rels, e->r);
+		if (!l || !r || l == r)
+			continue;
+		li = planner_find(p, l);
+		ri = planner_find(p, r);
+		p->el[p->nedges] = li;
+		p->er[p->nedges] = ri;
+		p->sel[p->nedges] = rel_join_exp_selectivity(sql, l, r, e, MAX((lng) p->card[li], 1), MAX((lng) p->card[ri], 1));
+		p->nedges++;
 	}
-	return changes; 
+	return p;
 }
 
-/* Rule 2: Right Associativity (A join B) join C -> A join (B join C) */
-static int 
-memoitem_apply_r2(memoitem *mi, sql_allocator *sa, list *memo)
+static int
+exps_in_rel(sql_rel *rel, list *exps)
 {
-	int changes = 0;
 	node *n;
 
-	if (!mi->joins || mi->level <= 2)
-		return 0;
-	for ( n = mi->joins->h; n; n = n->next) {
-		memojoin *mj = n->data;
-
-		if (mj->rules <= 1 && mj->l->level >= 2) {
-			node *m;
-
-			for( m = mj->l->joins->h; m; m = m->next) {
-				memoitem *r = NULL;
-				memojoin *mjl = m->data;
-				/* combine mjl->r and mj->r */
-				char *name = merge_names(sa, mjl->r->name, mj->r->name);
-
-				if ((r = memo_find(memo, name))) {
-					memojoin *mjn = SA_ZNEW(sa, memojoin);
-
-					mjn->l = mjl->l; 
-					mjn->r = r;
-					mjn->rules = 2;
-					mjn->cost = 0;
-					mjn->sel = 1;
-					list_append(mi->joins, mjn);
-					changes ++;
-				}
-			}
-			if (mj->rules)
-				mj->rules = 4;
-			else
-				mj->rules = 2;
-		}
-	}
-	return changes; 
+	for (n = exps->h; n; n = n->next)
+		if (!rel_find_exp(rel, n->data))
+			return 0;
+	return 1;
 }
 
-/* Rule 4: Exchange (A join B) join (C join D) -> (A join C) join (B join D) 
-static int 
-memoitem_apply_r4(memoitem *mi, sql_allocator *sa, list *memo)
+/* all the operands of the predicate e are bound by rel */
+static int
+exp_in_rel(sql_rel *rel, sql_exp *e)
 {
-	int changes = 0;
-	node *n;
-
-	if (!mi->joins || mi->level <= 2)
+	if (e->type != e_cmp)
 		return 0;
-	for ( n = mi->joins->h; n; n = n->next) {
-		memojoin *mj = n->data;
-
-		if (mj->rules <= 1 && mj->l->level >= 2) {
-			node *m;
-
-			for( m = mj->l->joins->h; m; m = m->next) {
-				memoitem *r = NULL;
-				memojoin *mjl = m->data;
-				char *name = merge_names(sa, mjl->r->name, mj->r->name);
-
-				if ((r = memo_find(memo, name))) {
-					memojoin *mjn = SA_ZNEW(sa, memojoin);
-
-					mjn->l = mjl->l; 
-					mjn->r = r;
-					mjn->rules = 2;
-					mjn->cost = 0;
-					list_append(mi->joins, mjn);
-					changes ++;
-				}
-			}
-			if (mj->rules)
-				mj->rules = 4;
-			else
-				mj->rules = 2;
-		}
+	switch (get_cmp(e)) {
+	case cmp_or:	/* left to the selection on top */
+		return 0;
+	case cmp_filter:
+		return exps_in_rel(rel, e->l) && exps_in_rel(rel, e->r);
+	case cmp_in:
+	case cmp_notin:
+		return rel_find_exp(rel, e->l) && exps_in_rel(rel, e->r);
+	default:
+		return rel_find_exp(rel, e->l) && rel_find_exp(rel, e->r) &&
+			(!e->f || rel_find_exp(rel, e->f));
 	}
-	return changes; 
 }
- * */
 
-static void
-memo_apply_rules(list *memo, sql_allocator *sa, int len) 
+/* join two trees, adding all the join predicates on their relations */
+static plantree
+planner_join(planner *p, plantree l, plantree r, dbl card, list *exps)
 {
-	int level;
-	node *n;
+	plantree t;
+	node *n, *nxt;
 
-	for (level = 2; level<=len; level++) {
-		int gchanges = 1;
-
-		while(gchanges) {
-			gchanges = 0;
-			for ( n = memo->h; n; n = n->next) {
-				int changes = 0;
-				memoitem *mi = n->data;
-		
-				if (!mi->done && mi->level == level) {
-					changes += memoitem_apply_r1(mi, sa);
-					changes += memoitem_apply_r2(mi, sa, memo);
-					//changes += memoitem_apply_r4(mi, sa, memo);
-		
-					if (!changes)
-						mi->done = 1;
-				}
-				gchanges |= changes;
-			}
-		}
-	}
-}
+	if (l.card < r.card) {	/* keep the largest relation on the left */
+		plantree s = l;
 
-static void
-memo_locate_exps( list *memo )
-{
-	node *n, *m, *o;
-
-	for(n = memo->h; n; n = n->next) {
-		memoitem *mi = n->data;
-		int prop = 0;
-
-		if (mi->level == 2) {
-			sql_exp *e = mi->data;
-
-			if (find_prop(e->p, PROP_HASHIDX))
-				prop = p_pkey;
-			if (find_prop(e->p, PROP_JOINIDX))
-				prop = p_fkey;
-
-			if (prop) {
-				for (m = mi->joins->h; m; m = m->next) {
-					memojoin *mj = m->data;
-					sql_exp *e = mj->e;
-
-					mj->prop = prop;
-					if (prop == p_fkey) {
-						sql_rel *l = mj->l->data, *f = NULL;
-						if (!l)
-							continue;
-						if (e)
-							f = find_one_rel(mi->rels, e->l);
-						if (f != l) /* we dislike swapped pkey/fkey joins */
-							mj->prop = 0;
-					}
-				}
-			}
-		} else if (mi->level > 2) {
-			/* find exp which isn't in the mj->l/r->exps lists */
-			for( o = mi->exps->h; o; o = o->next) {
-				sql_exp *e = o->data;
-
-				for (m = mi->joins->h; m; m = m->next) {
-					memojoin *mj = m->data;
-
-					if (list_find(mj->l->exps, e, NULL) == NULL &&
-					    list_find(mj->r->exps, e, NULL) == NULL) {
-						if (find_prop(e->p, PROP_HASHIDX))
-							prop = p_pkey;
-						if (find_prop(e->p, PROP_JOINIDX))
-							prop = p_fkey;
-						mj->prop = prop;
-						if (prop == p_fkey) {
-							sql_rel *l = find_one_rel(mi->rels, e->l); 
-							sql_rel *f = find_one_rel(mj->l->rels, e->l); 
-							if (!l)
-								continue;
-							if (f != l) /* we dislike swapped pkey/fkey joins */
-								mj->prop = 0;
-						}
-					}
-				}
-			}
-		}
+		l = r;
+		r = s;
 	}
-}
+	t.rel = rel_crossproduct(p->sql->sa, l.rel, r.rel, op_join);
+	t.card = card;
+	for (n = exps->h; n; n = nxt) {
+		sql_exp *e = n->data;
 
-static void
-memo_compute_cost(list *memo) 
-{
-	node *n, *m;
-
-	for ( n = memo->h; n; n = n->next) {
-		memoitem *mi = n->data;
-
-		if (mi->joins) {
-			lng cnt = 0, width = 1;
-		        dbl cost = 0;
-
-			/* cost minimum of join costs */
-			for ( m = mi->joins->h; m; m = m->next ) {
-				memojoin *mj = m->data;
-
-				lng mincnt = MIN(mj->l->count, mj->r->count);
-				dbl nsel = mj->sel;
-				lng ocnt = MAX((lng) (mincnt*nsel), 1);
-				dbl ncost = 0;
-
-				/* mincnt*mincnt_size_width*hash_const_cost + mincnt * output_width(for now just sum of width) * memaccess const */
-				/* current consts are 1 and 1 */
-				//ncost += ocnt * MIN(mj->l->width, mj->r->width);
-				width = (mj->l->count < mj->r->count)?mj->l->width:mj->r->width;
-				ncost += (mincnt * width * 1 ) + ocnt * (mj->l->width + mj->r->width) * 1;
-				assert(mj->l->cost > 0 && mj->r->cost > 0); 
-				ncost += mj->l->cost; /* add cost of left */
-				ncost += mj->r->cost; /* add cost of right */
-
-				width = mj->l->width + mj->r->width;
-				mj->cost = ncost;
-
-				if (cnt == 0) 
-					cnt = ocnt;
-				cnt = MIN(cnt,ocnt);
-
-				if (cost == 0) 
-					cost = ncost;
-				cost = MIN(cost,ncost);
-			}
-			assert(cnt > 0);
-			mi->count = cnt;
-			mi->cost = cost;
-			mi->width = width;
+		nxt = n->next;
+		if (exp_in_rel(t.rel, e)) {
+			rel_join_add_exp(p->sql->sa, t.rel, e);
+			list_remove_data(exps, e);
 		}
 	}
+	return t;
 }
 
-#ifndef HAVE_EMBEDDED
-static void
-memojoin_print( memojoin *mj )
+static plantree
+planner_leaf(planner *p, int i)
 {
-	printf("%s join-%s%d(cost=%f) %s", mj->l->name, mj->prop==p_pkey?"pkey":mj->prop==p_fkey?"fkey":"", mj->rules, mj->cost, mj->r->name);
-}
+	plantree t;
 
-static void
-memojoins_print( list *joins )
-{
-	node *n;
-
-	if (!joins)
-		return;
-	for(n=joins->h; n; n = n->next) {
-		memojoin *mj = n->data;
-
-		memojoin_print( mj );
-		if (n->next)
-			printf(" | ");
-	}
+	t.rel = p->rels[i];
+	t.card = p->card[i];
+	return t;
 }
 
-static void
-memoitem_print( memoitem *mi )
+static int
+planner_lowest(int s)
 {
-	printf("# %s(count="LLFMT",width="LLFMT",cost=%f): ", mi->name, mi->count, mi->width, mi->cost);
-	memojoins_print(mi->joins);
+	int i;
+
+	for (i = 0; !(s & (1 << i)); i++)
+		;
+	return i;
 }
 
-static void
-memo_print( list *memo )
+/* build the cheapest join tree found for the set of relations s */
+static plantree
+planner_build(planner *p, list *exps, int *split, dbl *card, int s)
 {
-	node *n;
-	int level = 0;
+	plantree l, r;
 
-	for(n=memo->h; n; n = n->next) {
-		memoitem *mi = n->data;
+	if ((s & (s - 1)) == 0)
+		return planner_leaf(p, planner_lowest(s));
+	l = planner_build(p, exps, split, card, split[s]);
+	r = planner_build(p, exps, split, card, s ^ split[s]);
+	return planner_join(p, l, r, MAX(card[s], 1.0), exps);
+}
 
-		if (mi->level > level){
-			level = mi->level;
-			printf("\n");
+/* Dynamic programming over the connected sub sets of the relations,
+ * represented as bit masks. Returns the number of trees produced, one
+ * for each connected component of the join graph. */
+static int
+planner_dp(planner *p, list *exps, plantree *trees)
+{
+	int n = p->nrels, i, ntrees = 0;
+	int all = (1 << n) - 1, s, s1, s2, low, todo, comp;
+	int *adj = SA_ZNEW_ARRAY(p->sql->sa, int, n);
+	int *split = SA_ZNEW_ARRAY(p->sql->sa, int, all + 1);
+	char *conn = SA_ZNEW_ARRAY(p->sql->sa, char, all + 1);
+	dbl *card = SA_NEW_ARRAY(p->sql->sa, dbl, all + 1);
+	dbl *cost = SA_NEW_ARRAY(p->sql->sa, dbl, all + 1);
+
+	for (i = 0; i < p->nedges; i++) {
+		adj[p->el[i]] |= 1 << p->er[i];
+		adj[p->er[i]] |= 1 << p->el[i];
+	}
+	card[0] = 1;
+	for (s = 1; s <= all; s++) {
+		int reach, prev;
+
+		low = s & -s;
+		card[s] = card[s ^ low] * p->card[planner_lowest(s)];
+		for (i = 0; i < p->nedges; i++) {
+			int m = (1 << p->el[i]) | (1 << p->er[i]);
+
+			/* the predicates connecting the lowest relation */
+			if ((m & low) && (m & s) == m && m != low)
+				card[s] *= p->sel[i];
 		}
-		memoitem_print( mi );
-		printf("\n");
+		/* connected, if all relations are reached from the lowest */
+		reach = low;
+		do {
+			prev = reach;
+			for (i = 0; i < n; i++)
+				if (reach & (1 << i))
+					reach |= adj[i] & s;
+		} while (reach != prev);
+		conn[s] = reach == s;
+		cost[s] = 0;
 	}
-}
-#endif
-
-static memojoin *
-find_cheapest( list *joins )
-{
-	node *n;
-	memojoin *cur = NULL;
 
-	if (!joins)
-		return NULL;
-	cur = joins->h->data;
-	for ( n = joins->h; n; n = n->next) {
-		memojoin *mj = n->data;
+	/* the cost of a tree is the sum of its intermediate result sizes,
+	 * the halves of a connected set are joined by some predicate */
+	for (s = 1; s <= all; s++) {
+		if (!conn[s] || (s & (s - 1)) == 0)
+			continue;
+		low = s & -s;
+		cost[s] = -1;
+		for (s1 = (s - 1) & s; s1 > 0; s1 = (s1 - 1) & s) {
+			dbl c;
+
+			s2 = s ^ s1;
+			if (!(s1 & low) || !conn[s1] || !conn[s2])
+				continue;
+			c = cost[s1] + cost[s2] + MAX(card[s], 1.0);
+			if (cost[s] < 0 || c < cost[s]) {
+				cost[s] = c;
+				split[s] = s1;
+			}
+		}
+	}
 
-		if (cur->cost > mj->cost)
-			cur = mj;
+	/* the largest connected set holding the lowest relation left is a
+	 * connected component of the join graph */
+	for (todo = all; todo; todo ^= comp) {
+		comp = low = todo & -todo;
+		for (s = todo; s; s = (s - 1) & todo)
+			if (conn[s] && (s & low) && s > comp)
+				comp = s;
+		trees[ntrees++] = planner_build(p, exps, split, card, comp);
 	}
-	return cur;
+	return ntrees;
 }
 
-static sql_rel *
-memo_select_plan( mvc *sql, list *memo, memoitem *mi, list *sdje, list *exps)
+/* Greedy operator ordering: join the pair of trees with the smallest result */
+static int
+planner_greedy(planner *p, list *exps, plantree *trees)
 {
-	if (mi->level >= 2) {
-		memojoin *mj = find_cheapest(mi->joins);
-		sql_rel *top;
-	
-		top = rel_crossproduct(sql->sa, 
-			memo_select_plan(sql, memo, mj->l, sdje, exps), 
-			memo_select_plan(sql, memo, mj->r, sdje, exps),
-			op_join);
-		if (mi->level == 2) {
-			rel_join_add_exp(sql->sa, top, mi->data);
-			list_remove_data(sdje, mi->data);
-		} else {
-			node *djn;
-
-			/* all other join expressions on these 2 relations */
-			while((djn = list_find(sdje, mi->rels, (fcmp)&exp_joins_rels)) != NULL) {
-				sql_exp *e = djn->data;
-
-				rel_join_add_exp(sql->sa, top, e);
-				list_remove_data(sdje, e);
-			}
+	int n = p->nrels, i, j, e, ntrees = n;
+	int *tree = SA_NEW_ARRAY(p->sql->sa, int, n);	/* the tree holding a relation */
 
-			/* all other join expressions on these 2 relations */
-			while((djn = list_find(exps, mi->rels, (fcmp)&exp_joins_rels)) != NULL) {
-				sql_exp *e = djn->data;
-
-				rel_join_add_exp(sql->sa, top, e);
-				list_remove_data(exps, e);
+	for (i = 0; i < n; i++) {
+		trees[i] = planner_leaf(p, i);
+		tree[i] = i;
+	}
+	for (;;) {
+		int bl = -1, br = -1;
+		dbl best = 0;
+
+		for (e = 0; e < p->nedges; e++) {
+			int l = tree[p->el[e]], r = tree[p->er[e]], f;
+			dbl card;
+
+			if (l == r)
+				continue;
+			card = trees[l].card * trees[r].card;
+			for (f = 0; f < p->nedges; f++)
+				if ((tree[p->el[f]] == l && tree[p->er[f]] == r) ||
+					(tree[p->el[f]] == r && tree[p->er[f]] == l))
+					card *= p->sel[f];
+			if (bl < 0 || card < best) {
+				best = card;
+				bl = l;
+				br = r;
 			}
 		}
-		return top;
-	} else {
-		return mi->data;
+		if (bl < 0)
+			break;
+		trees[bl] = planner_join(p, trees[bl], trees[br], MAX(best, 1.0), exps);
+		for (i = 0; i < n; i++)
+			if (tree[i] == br)
+				tree[i] = bl;
+		trees[br].rel = NULL;
 	}
+	for (i = 0, j = 0; i < ntrees; i++)
+		if (trees[i].rel)
+			trees[j++] = trees[i];
+	return j;
 }
 
+/*
+ * Plan the join of the relations, using the distinct join expressions
+ * (djes) to estimate the sizes. The join expressions in exps are added
+ * to the joins as soon as all the relations they need are available,
+ * and removed from the list, as are the relations from rels.
+ * Returns NULL if the size of some relation can not be estimated.
+ */
 sql_rel *
-rel_planner(mvc *sql, list *rels, list *sdje, list *exps)
+rel_planner(mvc *sql, list *rels, list *djes, list *exps)
 {
-	list *memo = memo_create(sql, rels);
-	memoitem *mi;
-	sql_rel *top;
-
-	/* extend one attribute at a time */
-	memo_add_exps(memo, sql, rels, sdje);
-	memo_add_attr(memo, sql, rels, sdje);
-
-	memo_apply_rules(memo, sql->sa, list_length(rels));
-	memo_locate_exps(memo);
-	memo_compute_cost(memo);
-#ifndef HAVE_EMBEDDED
-	//if (0)
-		memo_print(memo);
-#endif
-	mi = memo->t->data;
-	top = memo_select_plan(sql, memo, mi, sdje, exps);
-	if (list_length(sdje) != 0)
-		list_merge (top->exps, sdje, (fdup)NULL);
-	return top;
-}
-
+	planner *p = planner_create(sql, rels, djes);
+	plantree *trees, top;
+	int i, j, ntrees;
 
+	if (!p)
+		return NULL;
+	trees = SA_NEW_ARRAY(sql->sa, plantree, p->nrels);
+	if (p->nrels <= PLANNER_DP)
+		ntrees = planner_dp(p, exps, trees);
+	else
+		ntrees = planner_greedy(p, exps, trees);
+
+	/* cross products for the unconnected parts, smallest first */
+	for (i = 1; i < ntrees; i++)
+		for (j = i; j > 0 && trees[j].card < trees[j - 1].card; j--) {
+			plantree t = trees[j];
+
+			trees[j] = trees[j - 1];
+			trees[j - 1] = t;
+		}
+	top = trees[0];
+	for (i = 1; i < ntrees; i++)
+		top = planner_join(p, top, trees[i], top.card * trees[i].card, exps);
+	for (i = 0; i < p->nrels; i++)
+		list_remove_data(rels, p->rels[i]);
+	return top.rel;
+}
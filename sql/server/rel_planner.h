@@ -13,5 +13,9 @@
 #include "sql_mvc.h"
 
 extern sql_rel * rel_planner(mvc *sql, list *rels, list *djes, list *ojes);
+extern dbl rel_select_exp_selectivity(mvc *sql, sql_rel *rel, sql_exp *e);
+extern lng rel_est_count(mvc *sql, sql_rel *rel);
+extern lng rel_est_distinct(mvc *sql, sql_rel *rel, sql_exp *e);
+extern lng rel_est_rows(mvc *sql, sql_rel *rel);
 
 #endif /*_REL_PLANNER_H_ */
@@ -18,7 +18,8 @@ typedef enum rel_prop {
 	PROP_FETCH,     /* fetchjoin */
 	PROP_REMOTE,    /* uri for remote execution */
 	PROP_USED,      /* number of times exp is used */
-	PROP_DISTRIBUTE /* used by merge tables when sql.affectedRows is the sum of several insert/update/delete statements */
+	PROP_DISTRIBUTE, /* used by merge tables when sql.affectedRows is the sum of several insert/update/delete statements */
+	PROP_RANGEFILTER /* range select the probe side of a join on the min/max of the build side keys */
 } rel_prop;
 
 typedef struct prop {
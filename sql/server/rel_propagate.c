@@ -619,6 +619,28 @@ rel_generate_subupdates(mvc *sql, sql_rel *rel, sql_table *t, int *changes)
 	return sel;
 }
 
+/* Route the rows to insert into the partitions of t in a single pass: they
+ * are sorted on the partition column once, such that the selection of each
+ * partition (and of the rows in none of them) takes a binary search and
+ * a slice, instead of a scan of all rows. Only with many partitions, as
+ * the sort costs a few scans (unless the rows are sorted already). */
+#define PARTITION_ROUTE_MIN 16
+
+static void
+rel_route_partitions(mvc *sql, sql_rel *rel, sql_table *t)
+{
+	sql_rel *inserts = rel->r;
+	sql_exp *pe;
+
+	if (!isPartitionedByColumnTable(t) || list_length(t->members.set) < PARTITION_ROUTE_MIN)
+		return;
+	inserts = rel_project(sql->sa, inserts, rel_projections(sql, inserts, NULL, 1, 1));
+	pe = exp_ref(sql->sa, (sql_exp *) list_fetch(inserts->exps, t->part.pcol->colnr));
+	set_direction(pe, 1);
+	inserts->r = list_append(new_exp_list(sql->sa), pe);
+	rel->r = inserts;
+}
+
 static sql_rel*
 rel_generate_subinserts(sql_query *query, sql_rel *rel, sql_rel **anti_rel, sql_exp **exception, sql_table *t, int *changes,
 						const char *operation, const char *desc)
@@ -631,6 +653,7 @@ rel_generate_subinserts(sql_query *query, sql_rel *rel, sql_rel **anti_rel, sql_
 	sql_subaggr *cf = sql_bind_aggr(sql->sa, sql->session->schema, "count", NULL);
 	char buf[BUFSIZ];
 
+	rel_route_partitions(sql, rel, t);
 	if(isPartitionedByColumnTable(t)) {
 		*anti_rel = rel_dup(rel->r);
 	} else if(isPartitionedByExpressionTable(t)) {
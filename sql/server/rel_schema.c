@@ -16,6 +16,7 @@
 #include "rel_remote.h"
 #include "rel_psm.h"
 #include "rel_propagate.h"
+#include "rel_matview.h"
 #include "sql_parser.h"
 #include "sql_privileges.h"
 #include "sql_partition.h"
@@ -1242,6 +1243,80 @@ rel_create_view(sql_query *query, sql_schema *ss, dlist *qname, dlist *column_sp
 	return NULL;
 }
 
+static sql_rel *
+rel_create_matview(sql_query *query, dlist *qname, dlist *column_spec, symbol *ast)
+{
+	mvc *sql = query->sql;
+	char *name = qname_table(qname);
+	char *sname = qname_schema(qname);
+	sql_schema *s = NULL;
+	sql_table *t = NULL, *bad;
+	sql_rel *sq;
+	int emode = sql->emode;
+	char *q;
+
+	if (sname && !(s = mvc_bind_schema(sql, sname)))
+		return sql_error(sql, 02, SQLSTATE(3F000) "CREATE MATERIALIZED VIEW: no such schema '%s'", sname);
+	if (s == NULL)
+		s = cur_schema(sql);
+	/* instantiate the query of the view */
+	if (emode == m_instantiate || emode == m_deps)
+		return schema_selects(query, s, ast);
+
+	if (STORE_READONLY)
+		return sql_error(sql, 06, SQLSTATE(25006) "Schema statements cannot be executed on a readonly database.");
+	if (!mvc_schema_privs(sql, s))
+		return sql_error(sql, 02, SQLSTATE(42000) "CREATE MATERIALIZED VIEW: access denied for %s to schema ;'%s'", stack_get_string(sql, "current_user"), s->base.name);
+	if (isTempSchema(s))
+		return sql_error(sql, 02, SQLSTATE(42000) "CREATE MATERIALIZED VIEW: materialized views cannot be temporary");
+	if (mvc_bind_table(sql, s, name))
+		return sql_error(sql, 02, SQLSTATE(42S01) "CREATE MATERIALIZED VIEW: name '%s' already in use", name);
+
+	/* the view is maintained by the changes of its tables */
+	sql->emode = m_deps;
+	sq = schema_selects(query, s, ast);
+	sql->emode = emode;
+	if (!sq)
+		return NULL;
+	if ((bad = rel_matview_bad_source(sql, sq)) != NULL)
+		return sql_error(sql, 02, SQLSTATE(42000) "CREATE MATERIALIZED VIEW: '%s' is not a persistent table", bad->base.name);
+
+	if (!(sq = schema_selects(query, s, ast)))
+		return NULL;
+	if ((t = mvc_create_table_as_subquery(sql, sq, s, name, column_spec, SQL_PERSIST, CA_COMMIT)) == NULL) {
+		rel_destroy(sq);
+		return NULL;
+	}
+	q = query_cleaned(QUERY(sql->scanner));
+	t->query = sa_strdup(sql->sa, q);
+	GDKfree(q);
+	return rel_insert(sql, rel_table(sql, ddl_create_table, s->base.name, t, SQL_PERSIST), sq);
+}
+
+static sql_rel *
+rel_refresh_matview(mvc *sql, dlist *qname)
+{
+	char *name = qname_table(qname);
+	char *sname = qname_schema(qname);
+	sql_schema *s = NULL;
+	sql_table *t = NULL;
+	sql_rel *q;
+
+	if (sname && !(s = mvc_bind_schema(sql, sname)))
+		return sql_error(sql, 02, SQLSTATE(3F000) "REFRESH MATERIALIZED VIEW: no such schema '%s'", sname);
+	if (s == NULL)
+		s = cur_schema(sql);
+	if (!(t = mvc_bind_table(sql, s, name)) || !isMatView(t))
+		return sql_error(sql, 02, SQLSTATE(42S02) "REFRESH MATERIALIZED VIEW: no such materialized view '%s'", name);
+	if (!mvc_schema_privs(sql, s))
+		return sql_error(sql, 02, SQLSTATE(42000) "REFRESH MATERIALIZED VIEW: access denied for %s to schema ;'%s'", stack_get_string(sql, "current_user"), s->base.name);
+	if (!(q = rel_matview_query(sql, t)))
+		return NULL;
+	return rel_list(sql->sa,
+			rel_delete(sql->sa, rel_basetable(sql, t, t->base.name), NULL),
+			rel_insert(sql, rel_basetable(sql, t, t->base.name), q));
+}
+
 static sql_rel *
 rel_schema2(sql_allocator *sa, int cat_type, char *sname, char *auth, int nr)
 {
@@ -2666,7 +2741,7 @@ rel_schemas(sql_query *query, symbol *s)
 	mvc *sql = query->sql;
 	sql_rel *ret = NULL;
 
-	if (s->token != SQL_CREATE_TABLE && s->token != SQL_CREATE_VIEW && STORE_READONLY) 
+	if (s->token != SQL_CREATE_TABLE && s->token != SQL_CREATE_VIEW && s->token != SQL_CREATE_MATVIEW && STORE_READONLY) 
 		return sql_error(sql, 06, SQLSTATE(25006) "Schema statements cannot be executed on a readonly database.");
 
 	switch (s->token) {
@@ -2730,6 +2805,17 @@ rel_schemas(sql_query *query, symbol *s)
 							  l->h->next->next->next->next->data.i_val,
 							  l->h->next->next->next->next->next->data.i_val); /* or replace */
 	} 	break;
+	case SQL_CREATE_MATVIEW:
+	{
+		dlist *l = s->data.lval;
+
+		ret = rel_create_matview(query, l->h->data.lval,
+					 l->h->next->data.lval,
+					 l->h->next->next->data.sym);
+	} 	break;
+	case SQL_REFRESH_MATVIEW:
+		ret = rel_refresh_matview(sql, s->data.lval);
+		break;
 	case SQL_DROP_TABLE:
 	{
 		dlist *l = s->data.lval;
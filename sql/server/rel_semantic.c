@@ -134,6 +134,8 @@ rel_semantic(sql_query *query, symbol *s)
 	case SQL_DECLARE_TABLE:
 	case SQL_CREATE_TABLE:
 	case SQL_CREATE_VIEW:
+	case SQL_CREATE_MATVIEW:
+	case SQL_REFRESH_MATVIEW:
 	case SQL_DROP_TABLE:
 	case SQL_DROP_VIEW:
 	case SQL_ALTER_TABLE:
@@ -17,6 +17,7 @@
 #include "mal_errors.h" /* for SQLSTATE() */
 
 static int exps_have_freevar(mvc *sql, list *exps);
+static sql_rel *rel_general_unnest(mvc *sql, sql_rel *rel, list *ad);
 
 /* check if the set is distinct for the set of free variables */
 static int
@@ -382,6 +383,42 @@ push_up_project_exp(mvc *sql, sql_rel *rel, sql_exp *e)
 	return e;
 }
 
+static int
+exps_have_analytic( list *exps )
+{
+	node *n;
+
+	if (!exps)
+		return 0;
+	for (n = exps->h; n; n = n->next) {
+		sql_exp *e = n->data;
+
+		if (is_analytic(e))
+			return 1;
+	}
+	return 0;
+}
+
+/*
+ * The bindings without matching rows are lost by the inner join (rel), add
+ * these again with an outer join of the (distinct) bindings (l) on the bound
+ * variables. The inner columns (iexps) are on the nullable side.
+ */
+static sql_rel *
+rel_outer_bindings(mvc *sql, sql_rel *l, sql_rel *rel, list *iexps, list *ad)
+{
+	list *fd = exps_label(sql->sa, exps_copy(sql->sa, ad), sql->label+1);
+	node *n, *m;
+
+	sql->label += list_length(ad);
+	rel = rel_project(sql->sa, rel, list_merge(iexps, fd, (fdup)NULL));
+	rel = rel_crossproduct(sql->sa, rel_dup(l), rel, op_left);
+	rel->exps = sa_list(sql->sa);
+	for (n = ad->h, m = fd->h; n && m; n = n->next, m = m->next)
+		append(rel->exps, exp_compare(sql->sa, exp_ref(sql->sa, (sql_exp*)n->data), exp_ref(sql->sa, (sql_exp*)m->data), cmp_equal_nil));
+	return rel;
+}
+
 static sql_rel *
 push_up_project(mvc *sql, sql_rel *rel, list *ad) 
 {
@@ -433,8 +470,26 @@ push_up_project(mvc *sql, sql_rel *rel, list *ad)
 
 		if (r && r->op == op_project && r->l) {
 			node *m;
+			sql_rel *l = rel->l, *n;
+			list *iexps = NULL;
+
+			/* window functions over an outer join also number the unmatched rows, 
+			 * compute these over the inner join and add the unmatched bindings later */
+			if (rel->op == op_left && ad && exps_have_analytic(r->exps) && is_distinct_set(sql, l, ad)) {
+				iexps = sa_list(sql->sa);
+				for (m=r->exps->h; m && iexps; m = m->next) {
+					sql_exp *e = m->data;
+
+					if (exp_name(e))
+						append(iexps, exp_ref(sql->sa, e));
+					else
+						iexps = NULL;
+				}
+				if (iexps)
+					rel->op = op_join;
+			}
 			/* move project up, ie all attributes of left + the old expression list */
-			sql_rel *n = rel_project( sql->sa, rel, 
+			n = rel_project( sql->sa, rel, 
 					rel_projections(sql, rel->l, NULL, 1, 1));
 
 			/* only pass bound variables */
@@ -480,6 +535,13 @@ push_up_project(mvc *sql, sql_rel *rel, list *ad)
 			if (r->r) {
 				list *exps = r->r, *oexps = n->r = sa_list(sql->sa);
 
+				/* order per freevars first, window functions (and per binding limits) depend on the partitions being consecutive */
+				for (m=ad?ad->h:NULL; m; m = m->next) {
+					sql_exp *e = exp_copy(sql->sa, m->data);
+
+					set_direction(e, 1);
+					append(oexps, e);
+				}
 				for (m=exps->h; m; m = m->next) {
 					sql_exp *e = m->data;
 
@@ -494,6 +556,8 @@ push_up_project(mvc *sql, sql_rel *rel, list *ad)
 			rel->r = r->l;
 			r->l = NULL;
 			rel_destroy(r);
+			if (iexps)
+				return rel_project(sql->sa, rel_outer_bindings(sql, l, n, iexps, ad), rel_projections(sql, n, NULL, 1, 1));
 			return n;
 		} else if (r && r->op == op_project && !r->l) {
 			sql_rel *l = rel->l;
@@ -521,13 +585,113 @@ push_up_project(mvc *sql, sql_rel *rel, list *ad)
 	return rel;
 }
 
+/*
+ * A limit on the inner side is a limit per binding of the outer side. Rewrite
+ * it into a row_number on the inner side (partitioned on the dependent
+ * variables once the project is pushed up) and filter on its result above the
+ * (set based) join. This requires distinct bindings, ie rel_general_unnest
+ * first introduces the distinct domain.
+ */
+static sql_rel *
+push_up_topn_per_binding(mvc *sql, sql_rel *rel, list *ad) 
+{
+	sql_rel *l = rel->l, *r = rel->r, *p = r->l, *rp;
+	sql_exp *le = NULL, *oe = NULL, *rn, *e;
+	sql_subtype *bt = sql_bind_localtype("bit"), *lt;
+	sql_subfunc *rnf, *add = NULL;
+	list *exps, *args;
+	int outer = 0;
+
+	if (list_empty(r->exps) || !p)
+		return NULL;
+	le = r->exps->h->data;
+	if (r->exps->h->next)
+		oe = r->exps->h->next->data;
+	if (!le || !exp_is_atom(le) || exp_is_null(sql, le) || (oe && (!exp_is_atom(oe) || exp_is_null(sql, oe))))
+		return NULL;
+	lt = exp_subtype(le);
+	if (oe && (subtype_cmp(lt, exp_subtype(oe)) != 0 || !(add = sql_bind_func_result(sql->sa, NULL, "sql_add", lt, lt, lt))))
+		return NULL;
+
+	if (!is_simple_project(p->op) || need_distinct(p)) 
+		p = rel_project(sql->sa, p, rel_projections(sql, p, NULL, 1, 1));
+	if (list_empty(p->exps))
+		return NULL;
+	e = exp_ref(sql->sa, (sql_exp*)p->exps->h->data);
+	if (!(rnf = sql_bind_func3(sql->sa, NULL, "row_number", exp_subtype(e), bt, bt, F_ANALYTIC)))
+		return NULL;
+	args = sa_list(sql->sa);
+	append(args, e);
+	append(args, exp_atom_bool(sql->sa, 0));
+	append(args, exp_atom_bool(sql->sa, 0));
+	rn = exp_op(sql->sa, args, rnf);
+	exp_label(sql->sa, rn, ++sql->label);
+	if (!p->r) /* push_up_project orders on the bound variables first */
+		p->r = sa_list(sql->sa);
+	rp = rel_project(sql->sa, p, rel_projections(sql, p, NULL, 1, 1));
+	append(rp->exps, rn);
+	/* compare in the type of the limit, a cast on the row number itself would hide the window function */
+	if (subtype_cmp(exp_subtype(rn), lt) != 0) {
+		rp = rel_project(sql->sa, rp, rel_projections(sql, p, NULL, 1, 1));
+		rn = exp_ref(sql->sa, rn);
+		rn = exp_convert(sql->sa, rn, exp_subtype(rn), lt);
+		exp_label(sql->sa, rn, ++sql->label);
+		append(rp->exps, rn);
+	}
+
+	/* remove old topn */
+	r->l = NULL;
+	rel_destroy(r);
+	rel->r = p;
+	exps = rel_projections(sql, rel, NULL, 1, 1);
+	rel->r = rp;
+	/* filter the inner join, the bindings without (remaining) rows are added again later */
+	if (rel->op == op_left) {
+		rel->op = op_join;
+		outer = 1;
+	}
+
+	rn = exp_ref(sql->sa, rn);
+	if (oe) {
+		rel = rel_select(sql->sa, rel, exp_compare(sql->sa, rn, oe, cmp_gt));
+		rn = exp_copy(sql->sa, rn);
+		le = exp_binop(sql->sa, le, oe, add);
+		rel_select_add_exp(sql->sa, rel, exp_compare(sql->sa, rn, le, cmp_lte));
+	} else {
+		rel = rel_select(sql->sa, rel, exp_compare(sql->sa, rn, le, cmp_lte));
+	}
+	if (outer)
+		rel = rel_outer_bindings(sql, l, rel, rel_projections(sql, p, NULL, 1, 1), ad);
+	return rel_project(sql->sa, rel, exps);
+}
+
 static sql_rel *
-push_up_topn(mvc *sql, sql_rel *rel) 
+push_up_topn(mvc *sql, sql_rel *rel, list *ad) 
 {
 	/* a dependent semi/anti join with a project on the right side, could be removed */
 	if (rel && (is_semi(rel->op) || is_join(rel->op)) && is_dependent(rel)) {
 		sql_rel *r = rel->r;
 
+		if (r && r->op == op_topn && ad && (rel->op == op_join || rel->op == op_left)) {
+			sql_rel *nrel = push_up_topn_per_binding(sql, rel, ad);
+
+			if (nrel)
+				return nrel;
+		}
+		/* (not) exists only checks for the first row */
+		if (r && r->op == op_topn && is_semi(rel->op) && list_empty(rel->exps) && list_length(r->exps) == 1) {
+			sql_exp *le = r->exps->h->data;
+
+			if (le && exp_is_atom(le) && !exp_is_null(sql, le) && !exp_is_zero(sql, le)) {
+				rel->r = r->l;
+				r->l = NULL;
+				rel_destroy(r);
+				return rel;
+			}
+		}
+		/* otherwise limit per binding, on the distinct bindings */
+		if (r && r->op == op_topn && ad && is_semi(rel->op))
+			return rel_general_unnest(sql, rel, ad);
 		if (r && r->op == op_topn) {
 			/* remove old topn */
 			rel->r = r->l;
@@ -1008,13 +1172,14 @@ rel_unnest_dependent(mvc *sql, sql_rel *rel)
 		if (rel_has_freevar(sql, r)){
 			list *ad = rel_dependent_var(sql, rel->l, rel->r);
 
-			if (r && is_simple_project(r->op)) {
+			/* window functions are computed per binding, ie need distinct bindings */
+			if (r && is_simple_project(r->op) && (!ad || !exps_have_analytic(r->exps) || is_distinct_set(sql, l, ad))) {
 				rel = push_up_project(sql, rel, ad);
 				return rel_unnest_dependent(sql, rel);
 			}
 
-			if (r && is_topn(r->op)) {
-				rel = push_up_topn(sql, rel);
+			if (r && is_topn(r->op) && (!ad || is_semi(rel->op) || is_distinct_set(sql, l, ad))) {
+				rel = push_up_topn(sql, rel, ad);
 				return rel_unnest_dependent(sql, rel);
 			}
 
@@ -316,6 +316,7 @@ mvc_trans(mvc *m)
 		fprintf(stderr, "#%s: starting transaction\n",
 			MT_thread_getname());
 	schema_changed = sql_trans_begin(m->session);
+	m->qc_version = qc_shared_version();
 	if (m->qc && (schema_changed || m->qc->nr > m->cache || err)){
 		if (schema_changed || err) {
 			int seqnr = m->qc->id;
@@ -533,11 +534,15 @@ build up the hash (not copied in the trans dup)) */
 	}
 	valide = sql_trans_validate(tr);
 	if (valide) {
+		int catalog_changed = qc_catalog_changed(tr);
+
 		if ((ok = sql_trans_commit(tr)) != SQL_OK) {
 			char *err = sql_message(SQLSTATE(40000) "%s transaction commit failed (perhaps your disk is full?) exiting (kernel error: %s)", operation, GDKerrbuf);
 			GDKfatal("%s", err);
 			_DELETE(err);
 		}
+		if (catalog_changed)
+			qc_shared_flush();
 	} else {
 		store_unlock();
 		msg = createException(SQL, "sql.commit", SQLSTATE(40000) "%s transaction is aborted because of concurrency conflicts, will ROLLBACK instead", operation);
@@ -553,8 +558,10 @@ build up the hash (not copied in the trans dup)) */
 		return msg;
 	}
 	sql_trans_end(m->session);
-	if (chain)
+	if (chain) {
 		sql_trans_begin(m->session);
+		m->qc_version = qc_shared_version();
+	}
 	store_unlock();
 	m->type = Q_TRANS;
 	if (mvc_debug)
@@ -614,8 +621,10 @@ mvc_rollback(mvc *m, int chain, const char *name, bool disabling_auto_commit)
 		if (tr->wtime)
 			tr->status = 1;
 		sql_trans_end(m->session);
-		if (chain) 
+		if (chain) {
 			sql_trans_begin(m->session);
+			m->qc_version = qc_shared_version();
+		}
 	}
 	msg = WLCrollback(m->clientid);
 	store_unlock();
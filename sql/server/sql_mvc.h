@@ -117,6 +117,7 @@ typedef struct mvc {
 	int timezone;		/* milliseconds west of UTC */
 	int cache;		/* some queries should not be cached ! */
 	int caching;		/* cache current query ? */
+	int qc_version;		/* catalog version of the shared query cache */
 	int reply_size;		/* reply size */
 	bool sizeheader;	/* print size header in result set */
 	int debug;
@@ -686,7 +686,7 @@ SQLCODE SQLERROR UNDER WHENEVER
 %token CHECK CONSTRAINT CREATE COMMENT NULLS FIRST LAST
 %token TYPE PROCEDURE FUNCTION sqlLOADER AGGREGATE RETURNS EXTERNAL sqlNAME DECLARE
 %token CALL LANGUAGE
-%token ANALYZE MINMAX SQL_EXPLAIN SQL_PLAN SQL_DEBUG SQL_TRACE PREP PREPARE EXEC EXECUTE
+%token ANALYZE MINMAX MATERIALIZED REFRESH SQL_EXPLAIN SQL_PLAN SQL_DEBUG SQL_TRACE PREP PREPARE EXEC EXECUTE
 %token DEFAULT DISTINCT DROP TRUNCATE
 %token FOREIGN
 %token RENAME ENCRYPTED UNENCRYPTED PASSWORD GRANT REVOKE ROLE ADMIN INTO
@@ -846,6 +846,8 @@ sql:
 		append_symbol(l, $4);
 		append_int(l, $5);
 		$$ = _symbol_create_list( SQL_ANALYZE, l); }
+ |  REFRESH MATERIALIZED VIEW qname
+		{ $$ = _symbol_create_list( SQL_REFRESH_MATVIEW, $4); }
  |  call_procedure_statement
  |  comment_on_statement
  ;
@@ -2029,6 +2031,13 @@ view_def:
 	  append_int(l, $1);
 	  $$ = _symbol_create_list( SQL_CREATE_VIEW, l ); 
 	}
+ |  create MATERIALIZED VIEW qname opt_column_list AS query_expression_def
+	{  dlist *l = L();
+	  append_list(l, $4);
+	  append_list(l, $5);
+	  append_symbol(l, $7);
+	  $$ = _symbol_create_list( SQL_CREATE_MATVIEW, l );
+	}
   ;
 
 query_expression_def:
@@ -2817,6 +2826,12 @@ drop_statement:
 	  append_int(l, $5 );
 	  append_int(l, $3 );
 	  $$ = _symbol_create_list( SQL_DROP_VIEW, l ); }
+ |  drop MATERIALIZED VIEW if_exists qname drop_action
+	{ dlist *l = L();
+	  append_list(l, $5 );
+	  append_int(l, $6 );
+	  append_int(l, $4 );
+	  $$ = _symbol_create_list( SQL_DROP_TABLE, l ); }
  |  drop TYPE qname drop_action
 	{ dlist *l = L();
 	  append_list(l, $3 );
@@ -5718,6 +5733,7 @@ non_reserved_word:
 | KEY		{ $$ = sa_strdup(SA, "key"); }
 | LAST		{ $$ = sa_strdup(SA, "last"); }
 | LEVEL		{ $$ = sa_strdup(SA, "level"); }
+| MATERIALIZED	{ $$ = sa_strdup(SA, "materialized"); }
 | MAXVALUE	{ $$ = sa_strdup(SA, "maxvalue"); }
 | MINMAX	{ $$ = sa_strdup(SA, "MinMax"); }
 | MINVALUE	{ $$ = sa_strdup(SA, "minvalue"); }
@@ -5731,6 +5747,7 @@ non_reserved_word:
 | PREP		{ $$ = sa_strdup(SA, "prep"); }
 | PRIVILEGES	{ $$ = sa_strdup(SA, "privileges"); }
 | QUARTER	{ $$ = sa_strdup(SA, "quarter"); }
+| REFRESH	{ $$ = sa_strdup(SA, "refresh"); }
 | REPLACE	{ $$ = sa_strdup(SA, "replace"); }
 | ROLE		{ $$ = sa_strdup(SA, "role"); }
 | SCHEMA	{ $$ = sa_strdup(SA, "schema"); }
@@ -6580,6 +6597,7 @@ char *token2string(tokens token)
 	SQL(CREATE_TRIGGER);
 	SQL(CREATE_TYPE);
 	SQL(CREATE_USER);
+	SQL(CREATE_MATVIEW);
 	SQL(CREATE_VIEW);
 	SQL(CROSS);
 	SQL(CURRENT_ROW);
@@ -6659,6 +6677,7 @@ char *token2string(tokens token)
 	SQL(PW_ENCRYPTED);
 	SQL(PW_UNENCRYPTED);
 	SQL(RANK);
+	SQL(REFRESH_MATVIEW);
 	SQL(RENAME_COLUMN);
 	SQL(RENAME_SCHEMA);
 	SQL(RENAME_TABLE);
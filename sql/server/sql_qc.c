@@ -27,6 +27,16 @@
  * Entries in the cache obtain a unique(?) cache entry number.
  * It can be used as an external name.
  *
+ * Each client keeps its own cache, which is flushed upon schema changes.
+ * Query templates are also kept in a server wide cache, such that a
+ * client can pick up the code compiled by another client for the same
+ * query text, schema, user and role. These entries are bound to the
+ * version of the catalog they were compiled against. The commit of a
+ * transaction that changes the catalog flushes the shared cache, and
+ * clients working on an older catalog neither use nor add entries.
+ * The shared cache is bounded, the least recently used entry is removed
+ * when it is full.
+ *
  * [todo]
  * The information retain for each cached item is back-end specific.
  * It should have a hook to update the initialize the cache entry
@@ -42,6 +52,27 @@
 #include "sql_mvc.h"
 #include "sql_atom.h"
 
+/* an entry in the shared cache */
+typedef struct sq {
+	struct sq *next, *prev;	/* most recently used first */
+	int key;		/* the hash key for the query text */
+	char *query;		/* the (escaped) query text */
+	sqlid schema;		/* the session schema, user and role */
+	sqlid user;
+	sqlid role;
+	int version;		/* catalog version the code is bound to */
+	sql_query_t type;
+	sql_subtype *params;	/* parameter types */
+	int paramlen;
+	int no_mitosis;
+	backend_code code;	/* private copy of the code */
+} sq;
+
+static MT_Lock qc_shared_lock = MT_LOCK_INITIALIZER("qc_shared_lock");
+static sq *qc_shared_first = NULL, *qc_shared_last = NULL;
+static int qc_shared_nr = 0, qc_shared_max = 0;
+static int qc_shared_vsn = 0;	/* bumped by each catalog change */
+
 qc *
 qc_create(int clientid, int seqnr)
 {
@@ -304,3 +335,257 @@ qc_size(qc *cache)
 {
 	return cache->nr;
 }
+
+/*
+ * The shared cache
+ * The entries are kept in a doubly linked list, most recently used first.
+ * The code is kept in a private copy, which is copied again into the
+ * namespace of a client when it is matched.
+ */
+void
+qc_shared_init(int size)
+{
+	MT_lock_set(&qc_shared_lock);
+	qc_shared_max = size < 0 ? 0 : size;
+	MT_lock_unset(&qc_shared_lock);
+}
+
+static void
+sq_unlink(sq *e)
+{
+	if (e->prev)
+		e->prev->next = e->next;
+	else
+		qc_shared_first = e->next;
+	if (e->next)
+		e->next->prev = e->prev;
+	else
+		qc_shared_last = e->prev;
+	e->next = e->prev = NULL;
+	qc_shared_nr--;
+}
+
+static void
+sq_push(sq *e)
+{
+	e->prev = NULL;
+	e->next = qc_shared_first;
+	if (qc_shared_first)
+		qc_shared_first->prev = e;
+	else
+		qc_shared_last = e;
+	qc_shared_first = e;
+	qc_shared_nr++;
+}
+
+static void
+sq_delete(sq *e)
+{
+	if (e->code)
+		backend_freecode(-1, e->code, 0, 0, NULL);
+	_DELETE(e->query);
+	_DELETE(e->params);
+	_DELETE(e);
+}
+
+void
+qc_shared_destroy(void)
+{
+	sq *e;
+
+	MT_lock_set(&qc_shared_lock);
+	while ((e = qc_shared_first) != NULL) {
+		sq_unlink(e);
+		sq_delete(e);
+	}
+	qc_shared_max = 0;
+	MT_lock_unset(&qc_shared_lock);
+}
+
+/* find the entry matching the query; the caller should hold the
+ * qc_shared_lock */
+static sq *
+sq_find(mvc *sql, atom **params, int plen, int key, const char *query)
+{
+	sq *e;
+
+	if (sql->qc_version != qc_shared_vsn)
+		return NULL;
+	for (e = qc_shared_first; e; e = e->next) {
+		if (e->key == key &&
+			e->schema == sql->session->schema->base.id &&
+			e->user == sql->user_id && e->role == sql->role_id &&
+			e->paramlen == plen && strcmp(e->query, query) == 0 &&
+			param_list_cmp(e->params, params, plen, e->type) == 0)
+			return e;
+	}
+	return NULL;
+}
+
+/* another client may have added the same query in the mean time */
+static int
+sq_exists(sq *e)
+{
+	sq *o;
+	int i;
+
+	for (o = qc_shared_first; o; o = o->next) {
+		if (o->key != e->key || o->schema != e->schema || o->user != e->user ||
+			o->role != e->role || o->paramlen != e->paramlen ||
+			strcmp(o->query, e->query) != 0)
+			continue;
+		for (i = 0; i < e->paramlen; i++)
+			if (o->params[i].type != e->params[i].type ||
+				o->params[i].digits != e->params[i].digits ||
+				o->params[i].scale != e->params[i].scale)
+				break;
+		if (i == e->paramlen)
+			return 1;
+	}
+	return 0;
+}
+
+cq *
+qc_shared_match(qc *cache, mvc *sql, sql_allocator *sa, char *qname, symbol *s, atom **params, int plen, int key, char *query)
+{
+	sq *e;
+	cq *n;
+	backend_code code = NULL;
+	sql_query_t type = Q_TABLE;
+	int no_mitosis = 0;
+
+	MT_lock_set(&qc_shared_lock);
+	if (qc_shared_max > 0 && (e = sq_find(sql, params, plen, key, query)) != NULL) {
+		/* move it to the front of the list */
+		sq_unlink(e);
+		sq_push(e);
+		code = backend_dupcode(cache->clientid, e->code, qname);
+		type = e->type;
+		no_mitosis = e->no_mitosis;
+	}
+	MT_lock_unset(&qc_shared_lock);
+	if (code == NULL)
+		return NULL;
+
+	n = qc_insert(cache, sa, NULL, qname, s, params, plen, key, type, query, no_mitosis, 0);
+	if (n == NULL) {
+		backend_freecode(cache->clientid, code, 0, 0, qname);
+		return NULL;
+	}
+	n->code = code;
+	return n;
+}
+
+void
+qc_shared_insert(mvc *sql, cq *q)
+{
+	sq *e;
+
+	if (qc_shared_max <= 0 || q->prepared || !q->code || !q->codestring ||
+		(q->type != Q_TABLE && q->type != Q_UPDATE))
+		return;
+	if ((e = ZNEW(sq)) == NULL)
+		return;
+	e->key = q->key;
+	e->schema = sql->session->schema->base.id;
+	e->user = sql->user_id;
+	e->role = sql->role_id;
+	e->version = sql->qc_version;
+	e->type = q->type;
+	e->paramlen = q->paramlen;
+	e->no_mitosis = q->no_mitosis;
+	e->query = _STRDUP(q->codestring);
+	if (q->paramlen) {
+		e->params = NEW_ARRAY(sql_subtype, q->paramlen);
+		if (e->params)
+			memcpy(e->params, q->params, q->paramlen * sizeof(sql_subtype));
+	}
+	e->code = backend_dupcode(-1, q->code, NULL);
+	if (e->query == NULL || (q->paramlen && e->params == NULL) || e->code == NULL) {
+		sq_delete(e);
+		return;
+	}
+
+	MT_lock_set(&qc_shared_lock);
+	if (qc_shared_max <= 0 || e->version != qc_shared_vsn || sq_exists(e)) {
+		MT_lock_unset(&qc_shared_lock);
+		sq_delete(e);
+		return;
+	}
+	sq_push(e);
+	while (qc_shared_nr > qc_shared_max) {
+		sq *l = qc_shared_last;
+
+		sq_unlink(l);
+		sq_delete(l);
+	}
+	MT_lock_unset(&qc_shared_lock);
+}
+
+int
+qc_shared_size(void)
+{
+	int nr;
+
+	MT_lock_set(&qc_shared_lock);
+	nr = qc_shared_nr;
+	MT_lock_unset(&qc_shared_lock);
+	return nr;
+}
+
+/* the version of the catalog, to be taken when a transaction starts */
+int
+qc_shared_version(void)
+{
+	int vsn;
+
+	MT_lock_set(&qc_shared_lock);
+	vsn = qc_shared_vsn;
+	MT_lock_unset(&qc_shared_lock);
+	return vsn;
+}
+
+/*
+ * A transaction that changes the catalog has written one of the system
+ * tables, which hold the schema objects and privileges.
+ */
+int
+qc_catalog_changed(sql_trans *tr)
+{
+	node *n, *m;
+
+	if (tr->schema_updates)
+		return 1;
+	if (!tr->wtime || !tr->schemas.set)
+		return 0;
+	for (n = tr->schemas.set->h; n; n = n->next) {
+		sql_schema *s = n->data;
+
+		if (!s->system || !s->base.wtime || !s->tables.set)
+			continue;
+		for (m = s->tables.set->h; m; m = m->next) {
+			sql_table *t = m->data;
+
+			if (t->system && t->base.wtime)
+				return 1;
+		}
+	}
+	return 0;
+}
+
+/* the catalog has changed, which outdates all the shared templates;
+ * the caller should hold the store lock, such that transactions that
+ * start in the mean time obtain the new catalog version */
+void
+qc_shared_flush(void)
+{
+	sq *e;
+
+	MT_lock_set(&qc_shared_lock);
+	qc_shared_vsn++;
+	while ((e = qc_shared_first) != NULL) {
+		sq_unlink(e);
+		sq_delete(e);
+	}
+	MT_lock_unset(&qc_shared_lock);
+}
@@ -53,5 +53,16 @@ extern int qc_size(qc *cache);
 extern int qc_isaquerytemplate(char *nme);
 extern int qc_isapreparedquerytemplate(char *nme);
 
+/* the shared cache keeps query templates around for all clients */
+#define DEFAULT_SHAREDCACHESIZE 256
+extern void qc_shared_init(int size);
+extern void qc_shared_destroy(void);
+extern cq *qc_shared_match(qc *cache, mvc *sql, sql_allocator *sa, char *qname, symbol *s, atom **params, int plen, int key, char *query);
+extern void qc_shared_insert(mvc *sql, cq *q);
+extern int qc_shared_size(void);
+extern int qc_shared_version(void);
+extern void qc_shared_flush(void);
+extern int qc_catalog_changed(sql_trans *tr);
+
 #endif /*_SQL_QC_H_*/
 
@@ -373,6 +373,8 @@ scanner_init_keywords(void)
 
 	failed += keywords_insert("ANALYZE", ANALYZE);
 	failed += keywords_insert("MINMAX", MINMAX);
+	failed += keywords_insert("MATERIALIZED", MATERIALIZED);
+	failed += keywords_insert("REFRESH", REFRESH);
 	failed += keywords_insert("EXPLAIN", SQL_EXPLAIN);
 	failed += keywords_insert("PLAN", SQL_PLAN);
 	failed += keywords_insert("DEBUG", SQL_DEBUG);
@@ -47,6 +47,7 @@ typedef enum tokens {
 	SQL_CREATE_TRIGGER,
 	SQL_CREATE_TYPE,
 	SQL_CREATE_USER,
+	SQL_CREATE_MATVIEW,
 	SQL_CREATE_VIEW,
 	SQL_CROSS,
 	SQL_CURRENT_ROW,
@@ -126,6 +127,7 @@ typedef enum tokens {
 	SQL_PW_ENCRYPTED,
 	SQL_PW_UNENCRYPTED,
 	SQL_RANK,
+	SQL_REFRESH_MATVIEW,
 	SQL_RENAME_COLUMN,
 	SQL_RENAME_SCHEMA,
 	SQL_RENAME_TABLE,
@@ -9,6 +9,7 @@
 #include "monetdb_config.h"
 #include "bat_storage.h"
 #include "bat_utils.h"
+#include "store_stats.h"
 #include "sql_string.h"
 #include "algebra.h"
 #include "gdk_atoms.h"
@@ -2382,7 +2383,7 @@ gtr_minmax( sql_trans *tr )
 }
 
 static int 
-tr_update_delta( sql_trans *tr, sql_delta *obat, sql_delta *cbat, int unique)
+tr_update_delta( sql_trans *tr, sql_delta *obat, sql_delta *cbat, int unique, sqlid id)
 {
 	int ok = LOG_OK;
 	BAT *ins, *cur = NULL;
@@ -2432,6 +2433,8 @@ tr_update_delta( sql_trans *tr, sql_delta *obat, sql_delta *cbat, int unique)
 	}
 	/* any inserts */
 	if (BUNlast(ins) > 0 || cbat->cleared) {
+		if (tr->parent == gtrans)
+			stats_append(id, ins, cbat->cleared);
 		if ((!obat->ibase && BATcount(ins) > SNAPSHOT_MINSIZE)){
 			/* swap cur and ins */
 			BAT *newcur = ins;
@@ -2486,6 +2489,8 @@ tr_update_delta( sql_trans *tr, sql_delta *obat, sql_delta *cbat, int unique)
 		/* any updates */
 		assert(!isEbat(cur));
 		if (BUNlast(ui) > 0) {
+			if (tr->parent == gtrans)
+				stats_update(id, cur, ui, uv);
 			if (void_replace_bat(cur, ui, uv, true) != GDK_SUCCEED) {
 				bat_destroy(ui);
 				bat_destroy(uv);
@@ -2516,7 +2521,7 @@ tr_update_delta( sql_trans *tr, sql_delta *obat, sql_delta *cbat, int unique)
 }
 
 static int 
-tr_merge_delta( sql_trans *tr, sql_delta *obat, int unique)
+tr_merge_delta( sql_trans *tr, sql_delta *obat, int unique, sqlid id)
 {
 	int ok = LOG_OK;
 	BAT *ins, *cur = NULL;
@@ -2542,15 +2547,17 @@ tr_merge_delta( sql_trans *tr, sql_delta *obat, int unique)
 	}
 	/* any inserts */
 	if (BUNlast(ins) > 0) {
+		if (tr->parent == gtrans)
+			stats_append(id, ins, 0);
 		if ((!obat->ibase && BATcount(ins) > SNAPSHOT_MINSIZE)){
 			/* swap cur and ins */
 			BAT *newcur = ins;
-			bat id = obat->bid;
+			bat bid = obat->bid;
 
 			if (unique)
 				BATkey(newcur, true);
 			obat->bid = obat->ibid;
-			obat->ibid = id;
+			obat->ibid = bid;
 
 			BATmsync(ins);
 			ins = cur;
@@ -2585,6 +2592,8 @@ tr_merge_delta( sql_trans *tr, sql_delta *obat, int unique)
 		/* any updates */
 		assert(!isEbat(cur));
 		if (BUNlast(ui) > 0) {
+			if (tr->parent == gtrans)
+				stats_update(id, cur, ui, uv);
 			if (void_replace_bat(cur, ui, uv, true) != GDK_SUCCEED) {
 				bat_destroy(ui);
 				bat_destroy(uv);
@@ -2721,8 +2730,17 @@ update_table(sql_trans *tr, sql_table *ft, sql_table *tt)
 				b->next = NULL;
 			}
 		} else if (tt->data && ft->base.allocated) {
-			if (tr_update_dbat(tr, tt->data, ft->data) != LOG_OK)
+			sql_dbat *tdb = tt->data;
+			size_t cnt = tdb->cnt;
+
+			if (tr_update_dbat(tr, tdb, ft->data) != LOG_OK)
 				ok = LOG_ERR;
+			else if (tr->parent == gtrans && tdb->cnt > cnt && !tdb->cleared)
+				for (n = tt->columns.set->h; n; n = n->next) {
+					sql_column *c = n->data;
+
+					stats_delete(c->base.id, (lng) (tdb->cnt - cnt));
+				}
 		} else if (ATOMIC_GET(&store_nr_active) == 1 && !ft->base.allocated) {
 			/* only insert/updates, merge earlier deletes */
 			if (!tt->data) {
@@ -2772,7 +2790,7 @@ update_table(sql_trans *tr, sql_table *ft, sql_table *tt)
 					b->next = NULL;
 				}
 			} else if (oc->data && cc->base.allocated) {
-				if (tr_update_delta(tr, oc->data, cc->data, cc->unique == 1) != LOG_OK) 
+				if (tr_update_delta(tr, oc->data, cc->data, cc->unique == 1, oc->base.id) != LOG_OK) 
 					ok = LOG_ERR;
 			} else if (ATOMIC_GET(&store_nr_active) == 1 && !cc->base.allocated) {
 				/* only deletes, merge earlier changes */
@@ -2781,7 +2799,7 @@ update_table(sql_trans *tr, sql_table *ft, sql_table *tt)
 					oc->data = timestamp_delta(o->data, oc->base.stime);
 				}
 				assert(oc->data);
-				if (tr_merge_delta(tr, oc->data, oc->unique == 1) != LOG_OK)
+				if (tr_merge_delta(tr, oc->data, oc->unique == 1, oc->base.id) != LOG_OK)
 					ok = LOG_ERR;
 				cc->data = NULL;
 			} else if (cc->data) {
@@ -2857,7 +2875,7 @@ update_table(sql_trans *tr, sql_table *ft, sql_table *tt)
 						b->next = NULL;
 					}
 				} else if (oi->data && ci->base.allocated) {
-					if (tr_update_delta(tr, oi->data, ci->data, 0) != LOG_OK)
+					if (tr_update_delta(tr, oi->data, ci->data, 0, oi->base.id) != LOG_OK)
 						ok = LOG_ERR;
 				} else if (ATOMIC_GET(&store_nr_active) == 1 && !ci->base.allocated) {
 					if (!oi->data) {
@@ -2865,7 +2883,7 @@ update_table(sql_trans *tr, sql_table *ft, sql_table *tt)
 						oi->data = timestamp_delta(o->data, oi->base.stime);
 					}
 					assert(oi->data);
-					if (tr_merge_delta(tr, oi->data, 0) != LOG_OK)
+					if (tr_merge_delta(tr, oi->data, 0, oi->base.id) != LOG_OK)
 						ok = LOG_ERR;
 					ci->data = NULL;
 				} else if (ci->data) {
@@ -2894,6 +2912,109 @@ update_table(sql_trans *tr, sql_table *ft, sql_table *tt)
 	return ok;
 }
 
+/* rebase the appends to cbat, which started from version sbat, on the
+ * committed version obat. The committed inserts are followed by the local
+ * ones and the committed updates are taken over, as the local transaction
+ * only appended. */
+static int
+rebase_delta(sql_delta *obat, sql_delta *sbat, sql_delta *cbat)
+{
+	BAT *ins, *nins;
+	log_bid ibid, uibid, uvbid;
+	int ok;
+
+	if (obat == sbat)
+		return LOG_OK;
+	if (obat->cleared || cbat->cleared ||
+	    obat->bid != sbat->bid || cbat->bid != sbat->bid ||
+	    obat->ibase != sbat->ibase || cbat->ibase != sbat->ibase)
+		return LOG_ERR;
+	if ((ins = temp_descriptor(cbat->ibid)) == NULL)
+		return LOG_ERR;
+	nins = BATslice(ins, (BUN) (sbat->cnt - sbat->ibase), BATcount(ins));
+	bat_destroy(ins);
+	if (nins == NULL)
+		return LOG_ERR;
+	if (cbat->cached) {
+		bat_destroy(cbat->cached);
+		cbat->cached = NULL;
+	}
+	ibid = cbat->ibid;
+	if ((cbat->ibid = ebat_copy(obat->ibid, obat->ibase, 0)) == BID_NIL) {
+		cbat->ibid = ibid;
+		bat_destroy(nins);
+		return LOG_ERR;
+	}
+	cbat->cnt = obat->cnt;
+	ok = delta_append_bat(cbat, nins);
+	bat_destroy(nins);
+	temp_destroy(ibid);
+	if (ok != LOG_OK || !obat->uibid || !obat->uvbid)
+		return ok;
+
+	uibid = ebat_copy(obat->uibid, 0, 0);
+	uvbid = ebat_copy(obat->uvbid, 0, 0);
+	if (uibid == BID_NIL || uvbid == BID_NIL) {
+		if (uibid != BID_NIL)
+			temp_destroy(uibid);
+		if (uvbid != BID_NIL)
+			temp_destroy(uvbid);
+		return LOG_ERR;
+	}
+	if (cbat->uibid)
+		temp_destroy(cbat->uibid);
+	if (cbat->uvbid)
+		temp_destroy(cbat->uvbid);
+	cbat->uibid = uibid;
+	cbat->uvbid = uvbid;
+	cbat->ucnt = obat->ucnt;
+	return LOG_OK;
+}
+
+/* only transactions which appended to ft, without reading, updating or
+ * deleting its rows, can be rebased */
+static int
+rebase_table(sql_trans *tr, sql_table *ft, sql_table *tt)
+{
+	sql_dbat *db = tt->data;
+	node *n, *m;
+
+	if (ft->base.allocated || ft->cleared || (db && db->cleared))
+		return LOG_ERR;
+	for (n = ft->columns.set->h, m = tt->columns.set->h; n && m; n = n->next, m = m->next) {
+		sql_column *cc = n->data;
+		sql_column *oc = m->data;
+
+		if (cc->base.rtime)
+			return LOG_ERR;
+		if (!cc->base.wtime || !cc->base.allocated || !cc->data)
+			continue;
+		if (rebase_delta(oc->data, timestamp_delta(oc->data, cc->base.stime), cc->data) != LOG_OK)
+			return LOG_ERR;
+		/* the committed version is the new start, ie. rebase only once */
+		cc->base.stime = ((sql_delta *) oc->data)->wtime;
+		((sql_delta *) cc->data)->wtime = cc->base.wtime = tr->wstime;
+	}
+	if (tt->idxs.set) {
+		for (n = ft->idxs.set->h, m = tt->idxs.set->h; n && m; n = n->next, m = m->next) {
+			sql_idx *ci = n->data;
+			sql_idx *oi = m->data;
+
+			if (ci->base.rtime)
+				return LOG_ERR;
+			/* some indices have no bats */
+			if (!oi->data || !ci->base.wtime || !ci->base.allocated || !ci->data)
+				continue;
+			if (rebase_delta(oi->data, timestamp_delta(oi->data, ci->base.stime), ci->data) != LOG_OK)
+				return LOG_ERR;
+			ci->base.stime = ((sql_delta *) oi->data)->wtime;
+			((sql_delta *) ci->data)->wtime = ci->base.wtime = tr->wstime;
+		}
+	}
+	ft->base.wtime = ft->s->base.wtime = tr->wtime = tr->wstime;
+	return LOG_OK;
+}
+
 static int 
 tr_log_delta( sql_trans *tr, sql_delta *cbat, int cleared, char tpe, oid id)
 {
@@ -3157,6 +3278,7 @@ bat_storage_init( store_functions *sf)
 	sf->clear_del = (clear_del_fptr)&clear_del;
 
 	sf->update_table = (update_table_fptr)&update_table;
+	sf->rebase_table = (update_table_fptr)&rebase_table;
 	sf->log_table = (update_table_fptr)&log_table;
 	sf->snapshot_table = (update_table_fptr)&snapshot_table;
 	sf->gtrans_update = (gtrans_update_fptr)&gtr_update;
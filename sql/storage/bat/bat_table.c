@@ -591,18 +591,59 @@ rids_diff(sql_trans *tr, rids *l, sql_column *lc, subrids *r, sql_column *rc )
 	return l;
 }
 
+/* the index columns stored with the table, which have to be compacted as
+ * well; single column hash indices only get dummy values */
+#define vacuum_idx(i) \
+	(idx_has_column((i)->type) && \
+	 !(hash_index((i)->type) && list_length((i)->columns) <= 1))
+
+static int
+table_vacuum_idxs(sql_table *t, sql_idx ***idxs)
+{
+	int nr = 0;
+	node *n;
+
+	*idxs = NULL;
+	if (!t->idxs.set)
+		return 0;
+	for (n = t->idxs.set->h; n; n = n->next) {
+		sql_idx *i = n->data;
+
+		if (vacuum_idx(i))
+			nr++;
+	}
+	if (nr && (*idxs = NEW_ARRAY(sql_idx*, nr)) == NULL)
+		return -1;
+	nr = 0;
+	for (n = t->idxs.set->h; n; n = n->next) {
+		sql_idx *i = n->data;
+
+		if (vacuum_idx(i))
+			(*idxs)[nr++] = i;
+	}
+	return nr;
+}
+
 static int
 table_vacuum(sql_trans *tr, sql_table *t)
 {
 	BAT *tids = delta_cands(tr, t);
 	BAT **cols;
+	sql_idx **idxs;
+	int nrcols = cs_size(&t->columns), nridxs, i, ok = LOG_OK;
 	node *n;
 
 	if (!tids)
 		return SQL_ERR;
-	cols = NEW_ARRAY(BAT*, cs_size(&t->columns));
+	if ((nridxs = table_vacuum_idxs(t, &idxs)) < 0) {
+		bat_destroy(tids);
+		return SQL_ERR;
+	}
+	/* the (ordered) candidates keep the order of the remaining rows */
+	cols = (BAT **) GDKzalloc((nrcols + nridxs) * sizeof(BAT *));
 	if (!cols) {
 		bat_destroy(tids);
+		_DELETE(idxs);
 		return SQL_ERR;
 	}
 	for (n = t->columns.set->h; n; n = n->next) {
@@ -611,37 +652,39 @@ table_vacuum(sql_trans *tr, sql_table *t)
 
 		if (v == NULL ||
 		    (cols[c->colnr] = BATproject(tids, v)) == NULL) {
-			BBPunfix(tids->batCacheid);
-			for (n = t->columns.set->h; n; n = n->next) {
-				if (n->data == c)
-					break;
-				bat_destroy(cols[((sql_column *) n->data)->colnr]);
-			}
 			bat_destroy(v);
-			_DELETE(cols);
-			return SQL_ERR;
+			ok = LOG_ERR;
+			break;
+		}
+		BBPunfix(v->batCacheid);
+	}
+	for (i = 0; ok == LOG_OK && i < nridxs; i++) {
+		BAT *v = store_funcs.bind_idx(tr, idxs[i], RDONLY);
+
+		if (v == NULL ||
+		    (cols[nrcols + i] = BATproject(tids, v)) == NULL) {
+			bat_destroy(v);
+			ok = LOG_ERR;
+			break;
 		}
 		BBPunfix(v->batCacheid);
 	}
 	BBPunfix(tids->batCacheid);
-	sql_trans_clear_table(tr, t);
-	for (n = t->columns.set->h; n; n = n->next) {
-		sql_column *c = n->data;
-		int ok;
-
-		ok = store_funcs.append_col(tr, c, cols[c->colnr], TYPE_bat);
-		BBPunfix(cols[c->colnr]->batCacheid);
-		if (ok != LOG_OK) {
-			for (n = n->next; n; n = n->next) {
-				c = n->data;
-				BBPunfix(cols[c->colnr]->batCacheid);
-			}
-			_DELETE(cols);
-			return SQL_ERR;
+	if (ok == LOG_OK) {
+		sql_trans_clear_table(tr, t);
+		for (n = t->columns.set->h; ok == LOG_OK && n; n = n->next) {
+			sql_column *c = n->data;
+
+			ok = store_funcs.append_col(tr, c, cols[c->colnr], TYPE_bat);
 		}
+		for (i = 0; ok == LOG_OK && i < nridxs; i++)
+			ok = store_funcs.append_idx(tr, idxs[i], cols[nrcols + i], TYPE_bat);
 	}
+	for (i = 0; i < nrcols + nridxs; i++)
+		bat_destroy(cols[i]);
 	_DELETE(cols);
-	return SQL_OK;
+	_DELETE(idxs);
+	return ok == LOG_OK ? SQL_OK : SQL_ERR;
 }
 
 void
@@ -189,6 +189,8 @@ typedef BUN (*clear_del_fptr) (sql_trans *tr, sql_table *t);
 
 /*
 -- update_table rollforward the changes made from table ft to table tt 
+-- rebase_table moves the appends to table ft behind the changes committed
+-- concurrently to table tt (LOG_ERR when these conflict)
 -- returns LOG_OK, LOG_ERR
 */
 typedef int (*update_table_fptr) (sql_trans *tr, sql_table *ft, sql_table *tt); 
@@ -281,6 +283,7 @@ typedef struct store_functions {
 	update_table_fptr snapshot_table;
 	update_table_fptr log_table;
 	update_table_fptr update_table;
+	update_table_fptr rebase_table;
 	gtrans_update_fptr gtrans_update;
 	gtrans_update_fptr gtrans_minmax;
 
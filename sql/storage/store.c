@@ -11,6 +11,7 @@
 #include "sql_storage.h"
 #include "store_dependency.h"
 #include "store_sequence.h"
+#include "store_stats.h"
 
 #include "bat/bat_utils.h"
 #include "bat/bat_storage.h"
@@ -1777,6 +1778,8 @@ store_load(void) {
 
 	if(!sequences_init())
 		return -1;
+	if(!stats_init())
+		return -1;
 	gtrans = tr = create_trans(sa, backend_stk);
 	if(!gtrans)
 		return -1;
@@ -2026,51 +2029,114 @@ store_init(int debug, store_type store, int readonly, int singleuser, backend_st
 	return store_load();
 }
 
+/* user tables are compacted once at least VACUUM_USER_MIN_DELS and
+ * VACUUM_USER_DEL_PCT percent of their rows are deleted, and nothing got
+ * committed for VACUUM_USER_QUIET milliseconds */
+#define VACUUM_USER_MIN_DELS 1024
+#define VACUUM_USER_DEL_PCT 50
+#define VACUUM_USER_QUIET 1000
+
+/* a table referenced by foreign keys keeps its row ids, as these are stored
+ * in the join indices of the referencing tables */
 static int
-store_needs_vacuum( sql_trans *tr )
+table_is_referenced( sql_table *t )
 {
-	size_t max_dels = GDKdebug & FORCEMITOMASK ? 1 : 128;
-	sql_schema *s = find_sql_schema(tr, "sys");
 	node *n;
 
-	for( n = s->tables.set->h; n; n = n->next) {
-		sql_table *t = n->data;
-		sql_column *c = t->columns.set->h->data;
+	if (!t->keys.set)
+		return 0;
+	for (n = t->keys.set->h; n; n = n->next) {
+		sql_key *k = n->data;
 
-		if (!t->system)
-			continue;
-		/* no inserts, updates and enough deletes ? */
-		if (store_funcs.count_col(tr, c, 0) == 0 &&
-		    store_funcs.count_upd(tr, t) == 0 &&
-		    store_funcs.count_del(tr, t) >= max_dels)
+		if (k->type != fkey && !list_empty(((sql_ukey *) k)->keys))
 			return 1;
 	}
 	return 0;
 }
 
 static int
-store_vacuum( sql_trans *tr )
+table_needs_vacuum( sql_trans *tr, sql_table *t, int users )
 {
-	/* tables */
-	size_t max_dels = GDKdebug & FORCEMITOMASK ? 1 : 128;
-	sql_schema *s = find_sql_schema(tr, "sys");
-	node *n;
+	size_t max_dels = GDKdebug & FORCEMITOMASK ? 1 : 128, dels;
+	sql_column *c;
 
-	for( n = s->tables.set->h; n; n = n->next) {
-		sql_table *t = n->data;
-		sql_column *c = t->columns.set->h->data;
+	if (!isTable(t) || !t->columns.set || !t->columns.set->h ||
+	    store_funcs.count_upd(tr, t) != 0)
+		return 0;
+	c = t->columns.set->h->data;
+	dels = store_funcs.count_del(tr, t);
+	if (t->system) /* no inserts and enough deletes ? */
+		return store_funcs.count_col(tr, c, 0) == 0 && dels >= max_dels;
+	if (!users || t->persistence != SQL_PERSIST || t->commit_action != CA_COMMIT ||
+	    t->access == TABLE_READONLY || table_is_referenced(t))
+		return 0;
+	return dels >= VACUUM_USER_MIN_DELS &&
+		dels * 100 >= store_funcs.count_col(tr, c, 1) * VACUUM_USER_DEL_PCT;
+}
+
+static int
+store_needs_vacuum( sql_trans *tr, int users )
+{
+	node *m, *n;
+
+	for (m = tr->schemas.set->h; m; m = m->next) {
+		sql_schema *s = m->data;
+
+		if (!s->tables.set)
+			continue;
+		for (n = s->tables.set->h; n; n = n->next)
+			if (table_needs_vacuum(tr, n->data, users))
+				return 1;
+	}
+	return 0;
+}
+
+/* compact the tables with too many deleted rows, in the idle manager's own
+ * transaction, such that the compacted tables are swapped in on commit */
+static int
+store_vacuum( sql_trans *tr, int users )
+{
+	node *m, *n;
+
+	for (m = tr->schemas.set->h; m; m = m->next) {
+		sql_schema *s = m->data;
 
-		if (!t->system)
+		if (!s->tables.set)
 			continue;
-		if (store_funcs.count_col(tr, c, 0) == 0 &&
-		    store_funcs.count_upd(tr, t) == 0 &&
-		    store_funcs.count_del(tr, t) >= max_dels)
-			if (table_funcs.table_vacuum(tr, t) != SQL_OK)
+		for (n = s->tables.set->h; n; n = n->next) {
+			sql_table *t = n->data;
+
+			if (table_needs_vacuum(tr, t, users) &&
+			    table_funcs.table_vacuum(tr, t) != SQL_OK)
 				return -1;
+		}
 	}
 	return 0;
 }
 
+/* analyze the columns which changed too much since their last analysis */
+static void
+store_reanalyze( sql_trans *tr, sqlid colid, sqlid tabid )
+{
+	do {
+		sql_column *c = NULL;
+		node *n;
+		BAT *b;
+
+		for (n = tr->schemas.set->h; n && !c; n = n->next) {
+			sql_table *t = find_sql_table_id(n->data, tabid);
+			node *m = t ? list_find_base_id(t->columns.set, colid) : NULL;
+
+			if (m)
+				c = m->data;
+		}
+		if (!c || (b = store_funcs.bind_col(tr, c, RDONLY)) == NULL)
+			continue;
+		(void) stats_analyze(c, b);
+		BBPunfix(b->batCacheid);
+	} while (!GDKexiting() && stats_drifted(&colid, &tabid));
+}
+
 // All this must only be accessed while holding the bs_lock.
 // The exception is flush_now, which can be set by anyone at any
 // time and therefore needs some special treatment.
@@ -2179,6 +2245,7 @@ store_exit(void)
 	if (gtrans) {
 		MT_lock_unset(&bs_lock);
 		sequences_exit();
+		stats_exit();
 		MT_lock_set(&bs_lock);
 	}
 	if (spares > 0)
@@ -2293,11 +2360,13 @@ idle_manager(void)
 {
 	const int sleeptime = GDKdebug & FORCEMITOMASK ? 10 : 50;
 	const int timeout = GDKdebug & FORCEMITOMASK ? 50 : 5000;
+	int wstime = 0, quiet = 0;
 
 	MT_thread_setworking("sleeping");
 	while (!GDKexiting()) {
 		sql_session *s;
-		int t;
+		sqlid colid, tabid;
+		int t, drifted = 0, users;
 
 		for (t = timeout; t > 0; t -= sleeptime) {
 			MT_sleep_ms(sleeptime);
@@ -2307,7 +2376,15 @@ idle_manager(void)
 		/* cleanup any collected intermediate storage */
 		store_funcs.cleanup();
 		MT_lock_set(&bs_lock);
-		if (ATOMIC_GET(&store_nr_active) || GDKexiting() || !store_needs_vacuum(gtrans)) {
+		if (wstime != gtrans->wstime) {
+			wstime = gtrans->wstime;
+			quiet = 0;
+		} else if (quiet < VACUUM_USER_QUIET) {
+			quiet += timeout;
+		}
+		users = quiet >= VACUUM_USER_QUIET;
+		if (ATOMIC_GET(&store_nr_active) || GDKexiting() ||
+		    (!(drifted = stats_drifted(&colid, &tabid)) && !store_needs_vacuum(gtrans, users))) {
 			MT_lock_unset(&bs_lock);
 			continue;
 		}
@@ -2317,10 +2394,16 @@ idle_manager(void)
 			MT_lock_unset(&bs_lock);
 			continue;
 		}
-		MT_thread_setworking("vacuuming");
 		sql_trans_begin(s);
-		if (store_vacuum( s->tr ) == 0)
-			sql_trans_commit(s->tr);
+		if (drifted) {
+			MT_thread_setworking("analyzing");
+			store_reanalyze(s->tr, colid, tabid);
+		}
+		if (store_needs_vacuum(s->tr, users)) {
+			MT_thread_setworking("vacuuming");
+			if (store_vacuum( s->tr, users ) == 0)
+				sql_trans_commit(s->tr);
+		}
 		sql_trans_end(s);
 		sql_session_destroy(s);
 
@@ -3945,8 +4028,23 @@ rollforward_trans(sql_trans *tr, int mode)
 	return ok;
 }
 
+/* a transaction which only appended to a table doesn't conflict with the
+ * changes committed to it concurrently: its appends are moved behind the
+ * committed rows, with a write time after theirs */
+static int
+rebase_table(sql_trans *tr, sql_table *t, sql_table *ot, int *rebased)
+{
+	if (!isTable(t) || !t->base.wtime || isTempTable(t))
+		return 0;
+	if (!*rebased) {
+		tr->wtime = tr->wstime = timestamp();
+		*rebased = 1;
+	}
+	return store_funcs.rebase_table(tr, t, ot) == LOG_OK;
+}
+
 static int
-validate_tables(sql_schema *s, sql_schema *os)
+validate_tables(sql_trans *tr, sql_schema *s, sql_schema *os, int *rebased)
 {
 	node *n, *o, *p;
 
@@ -3954,6 +4052,7 @@ validate_tables(sql_schema *s, sql_schema *os)
 		for (n = s->tables.set->h; n; n = n->next) {
 			sql_table *t = n->data;
 			sql_table *ot;
+			int conflict = 0;
 
 			if (!t->base.wtime && !t->base.rtime)
 				continue;
@@ -3962,7 +4061,7 @@ validate_tables(sql_schema *s, sql_schema *os)
 			if (ot && isKindOfTable(ot) && isKindOfTable(t)) {
 				if ((t->base.wtime && (t->base.wtime < ot->base.rtime || t->base.wtime < ot->base.wtime)) ||
 				    (t->base.rtime && (t->base.rtime < ot->base.wtime))) 
-					return 0;
+					conflict = 1;
 				for (o = t->columns.set->h, p = ot->columns.set->h; o && p; o = o->next, p = p->next) {
 					sql_column *c = o->data;
 					sql_column *oc = p->data;
@@ -3974,11 +4073,13 @@ validate_tables(sql_schema *s, sql_schema *os)
 					/* read or write after t's write */
 					if (c->base.wtime && (c->base.wtime < oc->base.rtime
 							  ||  c->base.wtime < oc->base.wtime)) 
-						return 0;
+						conflict = 1;
 					/* commited write before t's read */
 					if (c->base.rtime && c->base.rtime < oc->base.wtime) 
 						return 0;
 				}
+				if (conflict && !rebase_table(tr, t, ot, rebased))
+					return 0;
 			}
 		}
 	return 1;
@@ -4274,6 +4375,7 @@ bool
 sql_trans_validate(sql_trans *tr)
 {
 	node *n;
+	int rebased = 0;
 
 	/* depends on the iso level */
 
@@ -4300,7 +4402,7 @@ sql_trans_validate(sql_trans *tr)
 
  			os = find_sql_schema(tr->parent, s->base.name);
 			if (os && (s->base.wtime != 0 || s->base.rtime != 0)) {
-				if (!validate_tables(s, os)) 
+				if (!validate_tables(tr, s, os, &rebased)) 
 					return false;
 			}
 		}
@@ -4625,6 +4727,7 @@ sys_drop_sequence(sql_trans *tr, sql_sequence * seq, int drop_action)
 static void
 sys_drop_statistics(sql_trans *tr, sql_column *col)
 {
+	stats_drop(col);
 	if (isGlobal(col->t)) {
 		sql_schema *syss = find_sql_schema(tr, "sys"); 
 		sql_table *sysstats = find_sql_table(syss, "statistics");
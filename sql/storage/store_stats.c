@@ -0,0 +1,527 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 1997 - July 2008 CWI, August 2008 - 2019 MonetDB B.V.
+ */
+
+/*
+ * The value distributions collected by ANALYZE, for use by the optimizers.
+ * Next to the summary kept in sys.statistics, each analyzed column gets
+ * an equi-depth histogram and a list of its most common values, both
+ * derived from a sample, and a HyperLogLog sketch of all its values
+ * which estimates the number of distinct values. The sketches of two
+ * sets of values can be merged into the sketch of their union.
+ *
+ * The distributions are kept in memory only, they are derived again by
+ * the next ANALYZE after a restart.
+ *
+ * Once analyzed, a column is maintained incrementally when the changes
+ * of a transaction are merged into the store: the tuple and nil counts
+ * and the sketch absorb the inserted and updated values, and the outer
+ * bounds of the histogram are widened to their minimum and maximum.
+ * When the changes since the last analysis exceed a fifth of the tuples
+ * analyzed, the column is queued for a full analysis by the store.
+ */
+#include "monetdb_config.h"
+#include "store_stats.h"
+#include "sql_storage.h"
+#include "gdk_cand.h"
+
+#define STATS_SAMPLE	8192	/* values used for histogram and common values */
+#define STATS_HLLBITS	10
+#define STATS_HLLSIZE	(1 << STATS_HLLBITS)	/* registers of the sketch */
+#define STATS_HASH	256
+#define STATS_DRIFT	5	/* analyze again after changing 1/STATS_DRIFT of the tuples */
+
+typedef struct store_stats {
+	struct store_stats *next;
+	sqlid colid;
+	sqlid tabid;
+	sql_colstats s;
+	lng analyzed;		/* tuples at the last analysis */
+	lng changed;		/* tuples inserted, updated or deleted since */
+	unsigned char hll[STATS_HLLSIZE];
+} store_stats;
+
+static MT_Lock stats_lock = MT_LOCK_INITIALIZER("stats_lock");
+static store_stats **stats_hash = NULL;
+
+void* stats_init(void)
+{
+	MT_lock_set(&stats_lock);
+	if (!stats_hash)
+		stats_hash = GDKzalloc(STATS_HASH * sizeof(store_stats *));
+	MT_lock_unset(&stats_lock);
+	return (void*) stats_hash;
+}
+
+void stats_exit(void)
+{
+	int i;
+
+	MT_lock_set(&stats_lock);
+	if (stats_hash) {
+		for (i = 0; i < STATS_HASH; i++) {
+			store_stats *st, *nxt;
+
+			for (st = stats_hash[i]; st; st = nxt) {
+				nxt = st->next;
+				GDKfree(st);
+			}
+		}
+		GDKfree(stats_hash);
+		stats_hash = NULL;
+	}
+	MT_lock_unset(&stats_lock);
+}
+
+/* lock is held */
+static store_stats **
+stats_find(sqlid colid)
+{
+	store_stats **st;
+
+	for (st = &stats_hash[(unsigned) colid % STATS_HASH]; *st; st = &(*st)->next)
+		if ((*st)->colid == colid)
+			break;
+	return st;
+}
+
+/* the value of a numeric or temporal type on a linear scale */
+static int
+stats_getdbl(int tpe, const void *v, dbl *d)
+{
+	switch (ATOMstorage(tpe)) {
+	case TYPE_bte:
+		*d = *(const bte *) v;
+		break;
+	case TYPE_sht:
+		*d = *(const sht *) v;
+		break;
+	case TYPE_int:
+		*d = *(const int *) v;
+		break;
+	case TYPE_lng:
+		*d = (dbl) *(const lng *) v;
+		break;
+#ifdef HAVE_HGE
+	case TYPE_hge:
+		*d = (dbl) *(const hge *) v;
+		break;
+#endif
+	case TYPE_flt:
+		*d = *(const flt *) v;
+		break;
+	case TYPE_dbl:
+		*d = *(const dbl *) v;
+		break;
+	default:
+		return 0;
+	}
+	return 1;
+}
+
+static void
+stats_hll_add(unsigned char *hll, ulng h)
+{
+	unsigned char rank = 1;
+	size_t j = (size_t) (h >> (64 - STATS_HLLBITS));
+
+	/* spread the bits of the (identity) atom hashes */
+	for (h <<= STATS_HLLBITS; rank <= 64 - STATS_HLLBITS && !(h & ((ulng) 1 << 63)); h <<= 1)
+		rank++;
+	if (hll[j] < rank)
+		hll[j] = rank;
+}
+
+static ulng
+stats_hash_value(int tpe, const void *v)
+{
+	ulng h = (ulng) ATOMhash(tpe, v);
+
+	/* the finalizer of splitmix64 */
+	h += 0x9E3779B97F4A7C15ULL;
+	h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+	return h ^ (h >> 31);
+}
+
+static dbl
+stats_hll_estimate(const unsigned char *hll)
+{
+	dbl m = STATS_HLLSIZE, sum = 0, est;
+	int i, zeros = 0;
+
+	for (i = 0; i < STATS_HLLSIZE; i++) {
+		sum += 1.0 / ((ulng) 1 << hll[i]);
+		zeros += hll[i] == 0;
+	}
+	est = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+	if (est <= 2.5 * m && zeros > 0)	/* small range correction */
+		est = m * log(m / zeros);
+	return est;
+}
+
+static void
+stats_set_ndv(store_stats *st)
+{
+	st->s.ndv = st->s.count > st->s.nils ? MAX(stats_hll_estimate(st->hll), 1.0) : 0;
+	if (st->s.ndv > st->s.count - st->s.nils)
+		st->s.ndv = (dbl) (st->s.count - st->s.nils);
+}
+
+/* Count the values and nils of b into st, add the values to its sketch
+ * and keep their minimum and maximum as its only histogram bounds */
+static void
+stats_scan(store_stats *st, BAT *b)
+{
+	BATiter bi = bat_iterator(b);
+	const void *nil = ATOMnilptr(b->ttype);
+	int (*cmp)(const void *, const void *) = ATOMcompare(b->ttype);
+	BUN p, q;
+	dbl d;
+
+	st->s.count += (lng) BATcount(b);
+	BATloop(b, p, q) {
+		const void *val = BUNtail(bi, p);
+
+		if (cmp(val, nil) == 0) {
+			st->s.nils++;
+			continue;
+		}
+		stats_hll_add(st->hll, stats_hash_value(b->ttype, val));
+		if (!stats_getdbl(b->ttype, val, &d))
+			continue;
+		if (st->s.nbounds == 0) {
+			st->s.bounds[0] = st->s.bounds[1] = d;
+			st->s.nbounds = 2;
+		} else if (d < st->s.bounds[0]) {
+			st->s.bounds[0] = d;
+		} else if (d > st->s.bounds[1]) {
+			st->s.bounds[1] = d;
+		}
+	}
+}
+
+static int
+dbl_cmp(const void *a, const void *b)
+{
+	dbl x = *(const dbl *) a, y = *(const dbl *) b;
+
+	return (x > y) - (x < y);
+}
+
+/* the histogram and the common values of a sorted sample of n values */
+static void
+stats_distribution(sql_colstats *s, dbl *v, BUN n)
+{
+	BUN i, j, runs = 0;
+	int k;
+
+	for (k = 0; k <= STATS_BUCKETS; k++)
+		s->bounds[k] = v[(BUN) ((dbl) k * (n - 1) / STATS_BUCKETS)];
+	s->nbounds = STATS_BUCKETS + 1;
+
+	for (i = 0; i < n; i = j, runs++)
+		for (j = i + 1; j < n && v[j] == v[i]; j++)
+			;
+	/* values which are more frequent than the average */
+	for (i = 0; i < n; i = j) {
+		BUN cnt;
+
+		for (j = i + 1; j < n && v[j] == v[i]; j++)
+			;
+		cnt = j - i;
+		if (cnt < 2 || cnt * runs * 4 <= n * 5)
+			continue;
+		for (k = s->nmcv; k > 0 && s->mcvfreq[k - 1] * n < cnt; k--)
+			if (k < STATS_MCV) {
+				s->mcv[k] = s->mcv[k - 1];
+				s->mcvfreq[k] = s->mcvfreq[k - 1];
+			}
+		if (k < STATS_MCV) {
+			s->mcv[k] = v[i];
+			s->mcvfreq[k] = (dbl) cnt / n;
+			if (s->nmcv < STATS_MCV)
+				s->nmcv++;
+		}
+	}
+}
+
+/* Analyze the values of column c, stored in b */
+int
+stats_analyze(sql_column *c, BAT *b)
+{
+	store_stats *st, **p;
+	BATiter bi = bat_iterator(b);
+	const void *nil = ATOMnilptr(b->ttype);
+	int (*cmp)(const void *, const void *) = ATOMcompare(b->ttype);
+	struct canditer ci;
+	BAT *smp = NULL;
+	BUN n;
+	oid o;
+	dbl *v = NULL, d, min, max;
+
+	if ((st = GDKzalloc(sizeof(store_stats))) == NULL)
+		return LOG_ERR;
+	st->colid = c->base.id;
+	st->tabid = c->t->base.id;
+	stats_scan(st, b);
+	stats_set_ndv(st);
+	st->analyzed = st->s.count;
+	min = st->s.bounds[0];
+	max = st->s.bounds[1];
+	st->s.nbounds = 0;
+
+	if (b->ttype != TYPE_void && st->s.count > st->s.nils &&
+	    stats_getdbl(b->ttype, nil, &d)) {
+		if (BATcount(b) > STATS_SAMPLE &&
+		    (smp = BATsample(b, STATS_SAMPLE)) == NULL) {
+			GDKfree(st);
+			return LOG_ERR;
+		}
+		if ((v = GDKmalloc(canditer_init(&ci, b, smp) * sizeof(dbl))) == NULL) {
+			if (smp)
+				BBPunfix(smp->batCacheid);
+			GDKfree(st);
+			return LOG_ERR;
+		}
+		n = 0;
+		while (!is_oid_nil(o = canditer_next(&ci))) {
+			const void *val = BUNtail(bi, o - b->hseqbase);
+
+			if (cmp(val, nil) != 0 && stats_getdbl(b->ttype, val, &d))
+				v[n++] = d;
+		}
+		if (smp)
+			BBPunfix(smp->batCacheid);
+		if (n > 0) {
+			qsort(v, n, sizeof(dbl), dbl_cmp);
+			stats_distribution(&st->s, v, n);
+			/* the sample may miss the extremes */
+			st->s.bounds[0] = min;
+			st->s.bounds[STATS_BUCKETS] = max;
+		}
+		GDKfree(v);
+	}
+
+	MT_lock_set(&stats_lock);
+	if (!stats_hash) {
+		MT_lock_unset(&stats_lock);
+		GDKfree(st);
+		return LOG_OK;
+	}
+	p = stats_find(st->colid);
+	if (*p) {
+		st->next = (*p)->next;
+		GDKfree(*p);
+	}
+	*p = st;
+	MT_lock_unset(&stats_lock);
+	return LOG_OK;
+}
+
+/* lock is held */
+static int
+stats_analyzed(sqlid colid)
+{
+	return stats_hash && *stats_find(colid) != NULL;
+}
+
+/* lock is held, merge the counts, sketch and bounds of d into st */
+static void
+stats_merge(store_stats *st, store_stats *d)
+{
+	int i;
+
+	st->s.nils += d->s.nils;
+	for (i = 0; i < STATS_HLLSIZE; i++)
+		if (st->hll[i] < d->hll[i])
+			st->hll[i] = d->hll[i];
+	if (d->s.nbounds && st->s.nbounds >= 2) {
+		if (d->s.bounds[0] < st->s.bounds[0])
+			st->s.bounds[0] = d->s.bounds[0];
+		if (d->s.bounds[1] > st->s.bounds[st->s.nbounds - 1])
+			st->s.bounds[st->s.nbounds - 1] = d->s.bounds[1];
+	}
+	stats_set_ndv(st);
+}
+
+/* The inserts ins of a committed transaction are merged into column colid */
+void
+stats_append(sqlid colid, BAT *ins, int cleared)
+{
+	store_stats d, *st;
+
+	MT_lock_set(&stats_lock);
+	if (!stats_analyzed(colid)) {
+		MT_lock_unset(&stats_lock);
+		return;
+	}
+	MT_lock_unset(&stats_lock);
+
+	memset(&d, 0, sizeof(d));
+	stats_scan(&d, ins);
+
+	MT_lock_set(&stats_lock);
+	if (stats_analyzed(colid)) {
+		st = *stats_find(colid);
+		if (cleared) {
+			/* the histogram and common values are gone with the
+			 * old tuples, until the column is analyzed again */
+			memset(st->hll, 0, sizeof(st->hll));
+			st->s.count = st->s.nils = 0;
+			st->s.nbounds = st->s.nmcv = 0;
+			st->changed += st->analyzed;
+		}
+		st->s.count += d.s.count;
+		st->changed += d.s.count;
+		stats_merge(st, &d);
+	}
+	MT_lock_unset(&stats_lock);
+}
+
+/* The values of the tuples ui of column cur will be replaced by uv */
+void
+stats_update(sqlid colid, BAT *cur, BAT *ui, BAT *uv)
+{
+	store_stats d, *st;
+	BATiter ci = bat_iterator(cur), ii = bat_iterator(ui);
+	const void *nil = ATOMnilptr(cur->ttype);
+	int (*cmp)(const void *, const void *) = ATOMcompare(cur->ttype);
+	BUN i, n = BATcount(ui);
+
+	MT_lock_set(&stats_lock);
+	if (!stats_analyzed(colid)) {
+		MT_lock_unset(&stats_lock);
+		return;
+	}
+	MT_lock_unset(&stats_lock);
+
+	memset(&d, 0, sizeof(d));
+	stats_scan(&d, uv);
+	/* the nils which are overwritten */
+	for (i = 0; i < n; i++) {
+		oid o = *(const oid *) BUNtail(ii, i);
+
+		if (o >= cur->hseqbase && o - cur->hseqbase < BATcount(cur) &&
+		    cmp(BUNtail(ci, o - cur->hseqbase), nil) == 0)
+			d.s.nils--;
+	}
+
+	MT_lock_set(&stats_lock);
+	if (stats_analyzed(colid)) {
+		st = *stats_find(colid);
+		st->changed += d.s.count;
+		stats_merge(st, &d);
+	}
+	MT_lock_unset(&stats_lock);
+}
+
+/* cnt tuples of the table of column colid were deleted */
+void
+stats_delete(sqlid colid, lng cnt)
+{
+	MT_lock_set(&stats_lock);
+	if (stats_analyzed(colid))
+		(*stats_find(colid))->changed += cnt;
+	MT_lock_unset(&stats_lock);
+}
+
+/* Find a column which changed too much since it was analyzed, its
+ * changes are forgotten, such that it is returned once only */
+int
+stats_drifted(sqlid *colid, sqlid *tabid)
+{
+	store_stats *st;
+	int i;
+
+	MT_lock_set(&stats_lock);
+	for (i = 0; stats_hash && i < STATS_HASH; i++) {
+		for (st = stats_hash[i]; st; st = st->next) {
+			if (st->changed > 0 && st->changed * STATS_DRIFT >= st->analyzed) {
+				st->changed = 0;
+				*colid = st->colid;
+				*tabid = st->tabid;
+				MT_lock_unset(&stats_lock);
+				return 1;
+			}
+		}
+	}
+	MT_lock_unset(&stats_lock);
+	return 0;
+}
+
+/* Copy the distribution of column c, returns 0 if it was not analyzed */
+int
+stats_get(sql_column *c, sql_colstats *s)
+{
+	store_stats *st;
+
+	MT_lock_set(&stats_lock);
+	st = stats_hash ? *stats_find(c->base.id) : NULL;
+	if (st)
+		*s = st->s;
+	MT_lock_unset(&stats_lock);
+	return st != NULL;
+}
+
+void
+stats_drop(sql_column *c)
+{
+	store_stats **p, *st;
+
+	MT_lock_set(&stats_lock);
+	if (stats_hash && (st = *(p = stats_find(c->base.id))) != NULL) {
+		*p = st->next;
+		GDKfree(st);
+	}
+	MT_lock_unset(&stats_lock);
+}
+
+static dbl
+stats_nonnil(sql_colstats *s)
+{
+	return s->count > 0 ? (dbl) (s->count - s->nils) / s->count : 1.0;
+}
+
+dbl
+stats_eq_selectivity(sql_colstats *s, dbl v)
+{
+	dbl rest = 1.0, sel;
+	int i;
+
+	if (s->nbounds > 0 && (v < s->bounds[0] || v > s->bounds[s->nbounds - 1]))
+		return 0;
+	for (i = 0; i < s->nmcv; i++) {
+		if (s->mcv[i] == v)
+			return s->mcvfreq[i] * stats_nonnil(s);
+		rest -= s->mcvfreq[i];
+	}
+	/* the other values are assumed to be equally frequent */
+	sel = rest / MAX(s->ndv - s->nmcv, 1.0);
+	return MAX(sel, 0) * stats_nonnil(s);
+}
+
+dbl
+stats_range_selectivity(sql_colstats *s, dbl lo, dbl hi)
+{
+	dbl sel = 0;
+	int i;
+
+	if (s->nbounds < 2)
+		return -1;
+	for (i = 0; i + 1 < s->nbounds; i++) {
+		dbl bl = s->bounds[i], bh = s->bounds[i + 1];
+
+		if (hi < bl || lo > bh)
+			continue;
+		if (bh == bl || (lo <= bl && hi >= bh))
+			sel += 1.0;
+		else	/* the values are spread evenly over the bucket */
+			sel += (MIN(hi, bh) - MAX(lo, bl)) / (bh - bl);
+	}
+	return sel / (s->nbounds - 1) * stats_nonnil(s);
+}
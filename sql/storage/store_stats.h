@@ -0,0 +1,48 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 1997 - July 2008 CWI, August 2008 - 2019 MonetDB B.V.
+ */
+
+#ifndef STORE_STATS_H
+#define STORE_STATS_H
+
+#include "sql_catalog.h"
+
+#define STATS_BUCKETS	32	/* buckets of the equi-depth histograms */
+#define STATS_MCV	16	/* size of the most common value lists */
+
+/* The value distribution of a column, as collected by ANALYZE.
+ * The histogram and most common values are only kept for the types
+ * with a numeric storage (including the temporal types). */
+typedef struct sql_colstats {
+	lng count;		/* tuples analyzed */
+	lng nils;
+	dbl ndv;		/* distinct values, estimated by the sketch */
+	int nbounds;		/* bounds of the equi-depth histogram */
+	dbl bounds[STATS_BUCKETS + 1];
+	int nmcv;
+	dbl mcv[STATS_MCV];
+	dbl mcvfreq[STATS_MCV];	/* fraction of the non-nil tuples */
+} sql_colstats;
+
+extern void* stats_init(void);
+extern void stats_exit(void);
+
+extern int stats_analyze(sql_column *c, BAT *b);
+extern int stats_get(sql_column *c, sql_colstats *s);
+extern void stats_drop(sql_column *c);
+
+/* maintenance of the analyzed columns, while committing */
+extern void stats_append(sqlid colid, BAT *ins, int cleared);
+extern void stats_update(sqlid colid, BAT *cur, BAT *ui, BAT *uv);
+extern void stats_delete(sqlid colid, lng cnt);
+extern int stats_drifted(sqlid *colid, sqlid *tabid);
+
+/* the fraction of the tuples equal to v, or in the range [lo, hi] */
+extern dbl stats_eq_selectivity(sql_colstats *s, dbl v);
+extern dbl stats_range_selectivity(sql_colstats *s, dbl lo, dbl hi);
+
+#endif /* STORE_STATS_H */
@@ -0,0 +1,18 @@
+-- after ANALYZE the selections are ordered on the value distributions
+create table skewed (a int, b int);
+insert into skewed select case when value % 100 = 0 then value else 1 end, value from generate_series(0, 10000);
+
+plan select count(*) from skewed where a = 200 and b < 5000;
+
+call sys.analyze(0, 0, 'sys', 'skewed');
+
+-- a = 1 holds for most tuples, a = 200 for very few
+plan select count(*) from skewed where a = 1 and b < 5000;
+plan select count(*) from skewed where a = 200 and b < 5000;
+plan select count(*) from skewed where b between 10 and 20 and a in (1, 2);
+
+select count(*) from skewed where a = 1 and b < 5000;
+select count(*) from skewed where a = 200 and b < 5000;
+select count(*) from skewed where b between 10 and 20 and a in (1, 2);
+
+drop table skewed;
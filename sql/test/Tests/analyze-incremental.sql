@@ -0,0 +1,15 @@
+-- the distributions of analyzed columns follow the committed changes
+create table grow (a int, b int);
+insert into grow select case when value % 100 = 0 then value else 1 end, value from generate_series(0, 10000);
+call sys.analyze(0, 0, 'sys', 'grow');
+
+-- no tuple has b above 10000 yet
+plan select count(*) from grow where a = 200 and b > 10000;
+
+insert into grow select 1, value from generate_series(10001, 20001);
+
+-- now half of them do, a = 200 is more selective
+plan select count(*) from grow where a = 200 and b > 10000;
+select count(*) from grow where a = 200 and b > 10000;
+
+drop table grow;
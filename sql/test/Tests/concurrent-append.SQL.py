@@ -0,0 +1,79 @@
+import sys
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+# run the statements of two concurrent sessions in a fixed order; each
+# statement is followed by a marker query, whose result tells it's done
+class Session:
+    def __init__(self):
+        self.clt = process.client('sql', stdin = process.PIPE,
+                                  stdout = process.PIPE, stderr = process.PIPE,
+                                  interactive = False, echo = True)
+        self.nr = 0
+
+    def run(self, query):
+        self.nr += 1
+        marker = 'done%d' % self.nr
+        self.clt.stdin.write("%s\nselect '%s';\n" % (query, marker))
+        self.clt.stdin.flush()
+        while True:
+            line = self.clt.stdout.readline()
+            if not line or line.startswith('[ "%s"' % marker):
+                break
+            if not line.startswith('%') and not line.startswith("#select 'done"):
+                sys.stdout.write(line)
+
+    def close(self):
+        out, err = self.clt.communicate()
+        sys.stderr.write(err)
+
+a = Session()
+b = Session()
+
+# appends to the same table don't conflict
+a.run("create table ca (i int, s varchar(10));")
+a.run("insert into ca values (1, 'one'), (2, 'two'), (3, 'three');")
+a.run("start transaction;")
+a.run("insert into ca values (10, 'ten');")
+b.run("start transaction;")
+b.run("insert into ca values (20, 'twenty');")
+b.run("commit;")
+a.run("insert into ca values (11, 'eleven');")
+a.run("commit;")
+b.run("select i, s from ca order by i;")
+
+# nor with committed updates and deletes of other rows
+a.run("start transaction;")
+a.run("insert into ca values (12, 'twelve');")
+b.run("start transaction;")
+b.run("update ca set s = 'TWO' where i = 2;")
+b.run("delete from ca where i = 3;")
+b.run("commit;")
+a.run("commit;")
+b.run("select i, s from ca order by i;")
+
+# a transaction which updated the table still conflicts
+a.run("start transaction;")
+a.run("update ca set s = 'ONE' where i = 1;")
+b.run("start transaction;")
+b.run("insert into ca values (21, 'twentyone');")
+b.run("commit;")
+a.run("commit;")
+
+# as do appends to a table with a key, as these are checked for duplicates
+a.run("create table cb (i int primary key);")
+a.run("start transaction;")
+a.run("insert into cb values (1);")
+b.run("start transaction;")
+b.run("insert into cb values (1);")
+b.run("commit;")
+a.run("commit;")
+b.run("select i, s from ca order by i;")
+b.run("select i from cb;")
+
+a.run("drop table ca;")
+a.run("drop table cb;")
+a.close()
+b.close()
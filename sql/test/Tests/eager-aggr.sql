@@ -0,0 +1,15 @@
+-- the fact rows are aggregated on the join key before the join
+create table dim (id int primary key, name varchar(10));
+insert into dim values (1, 'one'), (2, 'two'), (3, 'three'), (4, 'one');
+create table fact (dim_id int, amount int);
+insert into fact select value % 5, value from generate_series(0, 10000);
+insert into fact values (1, null), (null, 7);
+
+plan select d.name, sum(f.amount), count(*), min(f.amount), max(f.amount) from fact f, dim d where f.dim_id = d.id group by d.name;
+select d.name, sum(f.amount), count(*), count(f.amount), min(f.amount), max(f.amount) from fact f, dim d where f.dim_id = d.id group by d.name order by d.name;
+
+-- not when grouping on the fact side
+plan select f.amount, count(*) from fact f, dim d where f.dim_id = d.id group by f.amount;
+
+drop table fact;
+drop table dim;
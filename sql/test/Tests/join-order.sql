@@ -0,0 +1,21 @@
+-- the joins are ordered on the estimated sizes of the relations
+create table facts (id int, dim1 int, dim2 int, val int);
+create table dim1 (id int, name varchar(10));
+create table dim2 (id int, name varchar(10));
+insert into facts select value, value % 100, value % 3, value from generate_series(0, 10000);
+insert into dim1 select value, 'd' || value from generate_series(0, 100);
+insert into dim2 select value, 'e' || value from generate_series(0, 3);
+
+plan select count(*) from facts, dim1, dim2
+where facts.dim1 = dim1.id and facts.dim2 = dim2.id and dim2.name = 'e1';
+plan select count(*) from dim1, facts, dim2
+where dim2.id = facts.dim2 and dim1.id = facts.dim1 and dim1.name = 'd1';
+
+select count(*) from facts, dim1, dim2
+where facts.dim1 = dim1.id and facts.dim2 = dim2.id and dim2.name = 'e1';
+select count(*) from dim1, facts, dim2
+where dim2.id = facts.dim2 and dim1.id = facts.dim1 and dim1.name = 'd1';
+
+drop table facts;
+drop table dim1;
+drop table dim2;
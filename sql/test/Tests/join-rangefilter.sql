@@ -0,0 +1,19 @@
+-- the fact rows are range selected on the keys of the filtered dimension
+create table rdim (id int primary key, name varchar(10));
+insert into rdim select value, case when value < 100 then 'low' else 'high' end from generate_series(0, 1000);
+create table rfact (dim_id int, amount int);
+insert into rfact select value % 1000, value from generate_series(0, 100000);
+insert into rfact values (null, 1), (50, null);
+
+plan select d.name, f.amount from rfact f, rdim d where f.dim_id = d.id and d.name = 'low';
+select count(*), count(f.amount), sum(f.amount), min(f.dim_id), max(f.dim_id) from rfact f, rdim d where f.dim_id = d.id and d.name = 'low';
+select count(*), sum(f.amount) from rdim d, rfact f where d.id = f.dim_id and d.name = 'low' and d.id > 90;
+
+-- an empty build side
+select count(*) from rfact f, rdim d where f.dim_id = d.id and d.name = 'none';
+
+-- not without a filter on the dimension
+plan select d.name, f.amount from rfact f, rdim d where f.dim_id = d.id;
+
+drop table rfact;
+drop table rdim;
@@ -0,0 +1,50 @@
+import os, sys
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+def client(input, user = 'monetdb', passwd = 'monetdb'):
+    c = process.client('sql', user = user, passwd = passwd,
+                       stdin = process.PIPE,
+                       stdout = process.PIPE, stderr = process.PIPE,
+                       log = True)
+    out, err = c.communicate(input)
+    sys.stdout.write(out)
+    sys.stderr.write(err)
+
+client('''
+create table qc_shared (i int, s varchar(10));
+insert into qc_shared values (1, 'one'), (2, 'two'), (3, 'three');
+create user qc_user with password 'qc_user' name 'query cache user' schema sys;
+''')
+
+# the second client picks up the template compiled by the first one
+client('select sum(i) from qc_shared where i > 1;')
+client('select sum(i) from qc_shared where i > 1;')
+client('select sum(i) from qc_shared where i > 2;')
+
+# templates are not shared among users
+client('select sum(i) from qc_shared where i > 1;', 'qc_user', 'qc_user')
+
+# nor across schema changes
+client('''
+drop table qc_shared;
+create table qc_shared (i bigint, s varchar(10));
+insert into qc_shared values (10, 'ten'), (20, 'twenty');
+''')
+client('select sum(i) from qc_shared where i > 1;')
+
+# nor by clients with their own temporary tables
+client('''
+create local temporary table qc_shared (i int) on commit preserve rows;
+insert into tmp.qc_shared values (100);
+select sum(i) from tmp.qc_shared where i > 1;
+select sum(i) from sys.qc_shared where i > 1;
+''')
+client('select sum(i) from qc_shared where i > 1;')
+
+client('''
+drop user qc_user;
+drop table qc_shared;
+''')
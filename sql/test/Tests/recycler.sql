@@ -0,0 +1,28 @@
+-- intermediates kept by the recycler must follow the updates
+create table recycled (a int, b int);
+insert into recycled values (1, 10), (2, 20), (3, 30), (4, 40);
+
+set optimizer='recycler_pipe';
+
+select sum(b) from recycled where a > 1;
+select sum(b) from recycled where a > 1;
+
+insert into recycled values (5, 50);
+select sum(b) from recycled where a > 1;
+
+update recycled set b = b + 1 where a = 2;
+select sum(b) from recycled where a > 1;
+
+delete from recycled where a = 3;
+select sum(b) from recycled where a > 1;
+select a, b from recycled where a > 1 order by a;
+
+-- changes of the own transaction are not shared
+start transaction;
+insert into recycled values (6, 60);
+select sum(b) from recycled where a > 1;
+rollback;
+select sum(b) from recycled where a > 1;
+
+set optimizer='default_pipe';
+drop table recycled;
@@ -0,0 +1,26 @@
+-- identical subqueries are computed once and referenced
+create table sales (id int, region varchar(10), amount int);
+insert into sales select value, 'r' || (value % 3), value % 100 from generate_series(0, 1000);
+
+plan select region, s from (select region, sum(amount) as s from sales where amount > 10 group by region) as x where s > 100
+union all
+select region, s from (select region, sum(amount) as s from sales where amount > 10 group by region) as x where s < 100;
+
+select region, s from (select region, sum(amount) as s from sales where amount > 10 group by region) as x where s > 100
+union all
+select region, s from (select region, sum(amount) as s from sales where amount > 10 group by region) as x where s < 100
+order by region;
+
+-- different predicates are not shared
+plan select count(*) from sales where amount > 10
+union all
+select count(*) from sales where amount > 20;
+
+-- a common table expression is referenced, not copied
+plan with t as (select region, max(amount) as m from sales group by region)
+select t1.region, t2.m from t t1, t t2 where t1.region = t2.region;
+
+with t as (select region, max(amount) as m from sales group by region)
+select t1.region, t2.m from t t1, t t2 where t1.region = t2.region order by t1.region;
+
+drop table sales;
@@ -0,0 +1,46 @@
+import os, sys, time
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+def client(input):
+    c = process.client('sql', stdin = process.PIPE,
+                       stdout = process.PIPE, stderr = process.PIPE)
+    out, err = c.communicate(input)
+    return out, err
+
+def run(input):
+    out, err = client(input)
+    sys.stdout.write(out)
+    sys.stderr.write(err)
+
+def stored_rows():
+    out, err = client("select 'rows', \"count\" from sys.storage() where \"schema\" = 'sys' and \"table\" = 'vac' and \"column\" = 'a';")
+    for line in out.splitlines():
+        if line.startswith('[ "rows"'):
+            return int(line.split(',')[1].strip(' \t]'))
+    return -1
+
+# a multi column key has a (hash) index column, which is compacted as well
+run('''
+create table vac (a int, b int, c varchar(10), primary key (a, b));
+insert into vac select value, value % 7, 'v' || value from generate_series(0, 4000);
+delete from vac where a % 4 <> 0;
+''')
+
+# the idle manager compacts the table in the background
+for i in range(600):
+    if stored_rows() <= 1000:
+        break
+    time.sleep(0.1)
+sys.stdout.write('stored rows after vacuum: %d\n' % stored_rows())
+
+run('''
+select count(*), sum(a), min(c), max(c) from vac;
+select a, b, c from vac where a < 20;
+insert into vac values (8, 1, 'dup');
+insert into vac values (9, 2, 'new');
+select count(*) from vac where a = 8 or a = 9;
+drop table vac;
+''')
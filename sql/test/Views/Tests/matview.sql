@@ -0,0 +1,52 @@
+-- materialized views are maintained by the statements changing their tables
+create table sales (region varchar(10), product int, amount int);
+insert into sales values ('north', 1, 10), ('north', 2, 20), ('south', 1, 5);
+
+create materialized view sales_region as
+	select region, count(*) as cnt, sum(amount) as total, min(amount) as lo, max(amount) as hi
+	from sales group by region;
+create materialized view big_sales as select region, product, amount from sales where amount >= 10;
+
+select * from sales_region order by region;
+select * from big_sales order by region, product;
+
+-- the inserts are merged into the groups of the view
+insert into sales values ('north', 3, 30), ('east', 1, 7), ('south', 2, 50);
+select * from sales_region order by region;
+select * from big_sales order by region, product;
+
+-- updates and deletes recompute the views
+update sales set amount = amount * 2 where region = 'north';
+select * from sales_region order by region;
+select * from big_sales order by region, product;
+delete from sales where region = 'south';
+select * from sales_region order by region;
+select * from big_sales order by region, product;
+
+-- grouping the table is answered from the view
+plan select region, sum(amount) from sales group by region;
+select region, sum(amount) from sales group by region order by region;
+plan select region, count(*), max(amount) from sales where region <> 'east' group by region;
+select region, count(*), max(amount) from sales where region <> 'east' group by region order by region;
+
+-- the views cannot be changed directly
+insert into sales_region values ('west', 1, 1, 1, 1); --error
+delete from big_sales; --error
+
+-- refresh recomputes the view
+refresh materialized view sales_region;
+select * from sales_region order by region;
+
+truncate sales;
+select * from sales_region order by region;
+select * from big_sales order by region, product;
+
+-- only views on persistent tables are maintained
+create view v_sales as select * from sales;
+create materialized view mv_on_view as select count(*) as cnt from v_sales; --error
+drop view v_sales;
+
+drop table sales; --error, the views depend on it
+drop materialized view big_sales;
+drop materialized view sales_region;
+drop table sales;
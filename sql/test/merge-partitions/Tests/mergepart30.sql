@@ -0,0 +1,48 @@
+-- the partitions are pruned at run time, on the values compared with the partition column
+CREATE MERGE TABLE events (t int, v int) PARTITION BY RANGE ON (t);
+CREATE TABLE events1 (t int, v int);
+CREATE TABLE events2 (t int, v int);
+CREATE TABLE events3 (t int, v int);
+ALTER TABLE events ADD TABLE events1 AS PARTITION FROM 0 TO 100;
+ALTER TABLE events ADD TABLE events2 AS PARTITION FROM 100 TO 200;
+ALTER TABLE events ADD TABLE events3 AS PARTITION FROM 200 TO RANGE MAXVALUE;
+INSERT INTO events VALUES (1, 1), (50, 2), (150, 3), (199, 4), (200, 5), (1000, 6);
+
+PLAN SELECT v FROM events WHERE t = 150;
+
+PREPARE SELECT v FROM events WHERE t = ? ORDER BY v;
+exec **(150);
+exec **(200);
+exec **(-5);
+PREPARE SELECT count(*) FROM events WHERE t BETWEEN ? AND ?;
+exec **(40, 160);
+exec **(199, 199);
+PREPARE SELECT count(*) FROM events WHERE t >= ?;
+exec **(150);
+PREPARE SELECT count(*) FROM events WHERE t < ?;
+exec **(100);
+
+CREATE MERGE TABLE regions (r varchar(8), v int) PARTITION BY VALUES ON (r);
+CREATE TABLE regions1 (r varchar(8), v int);
+CREATE TABLE regions2 (r varchar(8), v int);
+ALTER TABLE regions ADD TABLE regions1 AS PARTITION IN ('north', 'east');
+ALTER TABLE regions ADD TABLE regions2 AS PARTITION IN ('south', 'west') WITH NULL VALUES;
+INSERT INTO regions VALUES ('north', 1), ('east', 2), ('south', 3), (NULL, 4);
+
+PREPARE SELECT v FROM regions WHERE r = ?;
+exec **('east');
+exec **('south');
+exec **('nowhere');
+
+ALTER TABLE events DROP TABLE events1;
+ALTER TABLE events DROP TABLE events2;
+ALTER TABLE events DROP TABLE events3;
+ALTER TABLE regions DROP TABLE regions1;
+ALTER TABLE regions DROP TABLE regions2;
+DROP TABLE events;
+DROP TABLE events1;
+DROP TABLE events2;
+DROP TABLE events3;
+DROP TABLE regions;
+DROP TABLE regions1;
+DROP TABLE regions2;
@@ -0,0 +1,80 @@
+-- with many partitions the rows inserted are routed to them in a single pass
+CREATE MERGE TABLE routed (a int, b varchar(32)) PARTITION BY RANGE ON (a);
+CREATE TABLE routed1 (a int, b varchar(32));
+CREATE TABLE routed2 (a int, b varchar(32));
+CREATE TABLE routed3 (a int, b varchar(32));
+CREATE TABLE routed4 (a int, b varchar(32));
+CREATE TABLE routed5 (a int, b varchar(32));
+CREATE TABLE routed6 (a int, b varchar(32));
+CREATE TABLE routed7 (a int, b varchar(32));
+CREATE TABLE routed8 (a int, b varchar(32));
+CREATE TABLE routed9 (a int, b varchar(32));
+CREATE TABLE routed10 (a int, b varchar(32));
+CREATE TABLE routed11 (a int, b varchar(32));
+CREATE TABLE routed12 (a int, b varchar(32));
+CREATE TABLE routed13 (a int, b varchar(32));
+CREATE TABLE routed14 (a int, b varchar(32));
+CREATE TABLE routed15 (a int, b varchar(32));
+CREATE TABLE routed16 (a int, b varchar(32));
+ALTER TABLE routed ADD TABLE routed1 AS PARTITION FROM 0 TO 100;
+ALTER TABLE routed ADD TABLE routed2 AS PARTITION FROM 100 TO 200;
+ALTER TABLE routed ADD TABLE routed3 AS PARTITION FROM 200 TO 300;
+ALTER TABLE routed ADD TABLE routed4 AS PARTITION FROM 300 TO 400;
+ALTER TABLE routed ADD TABLE routed5 AS PARTITION FROM 400 TO 500;
+ALTER TABLE routed ADD TABLE routed6 AS PARTITION FROM 500 TO 600;
+ALTER TABLE routed ADD TABLE routed7 AS PARTITION FROM 600 TO 700;
+ALTER TABLE routed ADD TABLE routed8 AS PARTITION FROM 700 TO 800;
+ALTER TABLE routed ADD TABLE routed9 AS PARTITION FROM 800 TO 900;
+ALTER TABLE routed ADD TABLE routed10 AS PARTITION FROM 900 TO 1000;
+ALTER TABLE routed ADD TABLE routed11 AS PARTITION FROM 1000 TO 1100;
+ALTER TABLE routed ADD TABLE routed12 AS PARTITION FROM 1100 TO 1200;
+ALTER TABLE routed ADD TABLE routed13 AS PARTITION FROM 1200 TO 1300;
+ALTER TABLE routed ADD TABLE routed14 AS PARTITION FROM 1300 TO 1400;
+ALTER TABLE routed ADD TABLE routed15 AS PARTITION FROM 1400 TO 1500;
+ALTER TABLE routed ADD TABLE routed16 AS PARTITION FROM 1500 TO 1600 WITH NULL VALUES;
+
+INSERT INTO routed SELECT (value * 7) % 1600, 'row' || value FROM generate_series(0, 4000);
+INSERT INTO routed VALUES (NULL, 'null');
+INSERT INTO routed SELECT value, 'out' FROM generate_series(1590, 1610); --error, 1600 and above are in no partition
+
+SELECT count(*), min(a), max(a) FROM routed;
+SELECT count(*), min(a), max(a), count(b) FROM routed1;
+SELECT count(*), min(a), max(a), count(b) FROM routed2;
+SELECT count(*), min(a), max(a), count(b) FROM routed15;
+SELECT count(*), min(a), max(a), count(b) FROM routed16;
+SELECT count(*) FROM routed WHERE a IS NULL;
+SELECT count(*) FROM routed16 WHERE a IS NULL;
+
+ALTER TABLE routed DROP TABLE routed1;
+ALTER TABLE routed DROP TABLE routed2;
+ALTER TABLE routed DROP TABLE routed3;
+ALTER TABLE routed DROP TABLE routed4;
+ALTER TABLE routed DROP TABLE routed5;
+ALTER TABLE routed DROP TABLE routed6;
+ALTER TABLE routed DROP TABLE routed7;
+ALTER TABLE routed DROP TABLE routed8;
+ALTER TABLE routed DROP TABLE routed9;
+ALTER TABLE routed DROP TABLE routed10;
+ALTER TABLE routed DROP TABLE routed11;
+ALTER TABLE routed DROP TABLE routed12;
+ALTER TABLE routed DROP TABLE routed13;
+ALTER TABLE routed DROP TABLE routed14;
+ALTER TABLE routed DROP TABLE routed15;
+ALTER TABLE routed DROP TABLE routed16;
+DROP TABLE routed;
+DROP TABLE routed1;
+DROP TABLE routed2;
+DROP TABLE routed3;
+DROP TABLE routed4;
+DROP TABLE routed5;
+DROP TABLE routed6;
+DROP TABLE routed7;
+DROP TABLE routed8;
+DROP TABLE routed9;
+DROP TABLE routed10;
+DROP TABLE routed11;
+DROP TABLE routed12;
+DROP TABLE routed13;
+DROP TABLE routed14;
+DROP TABLE routed15;
+DROP TABLE routed16;
@@ -503,8 +503,7 @@ SELECT i, (SELECT row_number() OVER (ORDER BY i) FROM integers WHERE i1.i=i) FRO
 --3	1
 --NULL	NULL
 
-/*Wrong results
-SELECT i1.i, (SELECT rank() OVER (ORDER BY i) FROM integers WHERE i1.i=i) FROM integers i1, integers i2 ORDER BY i1.i;*/
+SELECT i1.i, (SELECT rank() OVER (ORDER BY i) FROM integers WHERE i1.i=i) FROM integers i1, integers i2 ORDER BY i1.i;
 --NULL,	NULL
 --NULL,	NULL
 --NULL,	NULL
@@ -522,8 +521,7 @@ SELECT i1.i, (SELECT rank() OVER (ORDER BY i) FROM integers WHERE i1.i=i) FROM i
 --3,	1
 --3,	1
 
-/*Wrong results
-SELECT i1.i, (SELECT row_number() OVER (ORDER BY i) FROM integers WHERE i1.i=i) FROM integers i1, integers i2 ORDER BY i1.i;*/
+SELECT i1.i, (SELECT row_number() OVER (ORDER BY i) FROM integers WHERE i1.i=i) FROM integers i1, integers i2 ORDER BY i1.i;
 --1	1
 --1	1
 --1	1
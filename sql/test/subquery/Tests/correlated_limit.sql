@@ -0,0 +1,61 @@
+CREATE TABLE c1 (a INTEGER);
+INSERT INTO c1 VALUES (1), (2), (3), (NULL), (2);
+CREATE TABLE c2 (a INTEGER, b INTEGER);
+INSERT INTO c2 VALUES (1, 10), (1, 11), (1, 12), (2, 20), (2, 21), (4, 40);
+
+-- LIMIT per outer row
+SELECT a, (SELECT MIN(b) FROM (SELECT b FROM c2 WHERE c2.a = c1.a ORDER BY b DESC LIMIT 2) x) FROM c1 ORDER BY a;
+--NULL	NULL
+--1	11
+--2	20
+--2	20
+--3	NULL
+SELECT a, (SELECT MAX(b) FROM (SELECT b FROM c2 WHERE c2.a = c1.a ORDER BY b LIMIT 1) x) FROM c1 ORDER BY a;
+--NULL	NULL
+--1	10
+--2	20
+--2	20
+--3	NULL
+SELECT a, (SELECT MAX(b) FROM (SELECT b FROM c2 WHERE c2.a = c1.a ORDER BY b LIMIT 1 OFFSET 1) x) FROM c1 ORDER BY a;
+--NULL	NULL
+--1	11
+--2	21
+--2	21
+--3	NULL
+SELECT a FROM c1 WHERE 20 IN (SELECT b FROM (SELECT b FROM c2 WHERE c2.a = c1.a ORDER BY b LIMIT 1) x) ORDER BY a;
+--2
+--2
+SELECT a FROM c1 WHERE EXISTS (SELECT * FROM (SELECT b FROM c2 WHERE c2.a = c1.a LIMIT 1) x) ORDER BY a;
+--1
+--2
+--2
+SELECT a FROM c1 WHERE EXISTS (SELECT * FROM (SELECT b FROM c2 WHERE c2.a = c1.a ORDER BY b LIMIT 1 OFFSET 2) x) ORDER BY a;
+--1
+SELECT a FROM c1 WHERE 11 IN (SELECT b FROM (SELECT b FROM c2 WHERE c2.a = c1.a ORDER BY b LIMIT 2) x) ORDER BY a;
+--1
+SELECT a FROM c1 WHERE 12 IN (SELECT b FROM (SELECT b FROM c2 WHERE c2.a = c1.a ORDER BY b LIMIT 2) x) ORDER BY a;
+
+-- the limit is computed with a row_number per binding, no nested loop
+PLAN SELECT a, (SELECT MIN(b) FROM (SELECT b FROM c2 WHERE c2.a = c1.a ORDER BY b DESC LIMIT 2) x) FROM c1;
+
+-- window functions per outer row, also with duplicate outer rows
+SELECT a, (SELECT MAX(r) FROM (SELECT ROW_NUMBER() OVER (ORDER BY b) AS r FROM c2 WHERE c2.a = c1.a) x) FROM c1 ORDER BY a;
+--NULL	NULL
+--1	3
+--2	2
+--2	2
+--3	NULL
+SELECT c.a, (SELECT RANK() OVER (ORDER BY b) FROM c2 WHERE c2.a = c.a AND c2.b = 10 * c.a) FROM c1 c, c1 d WHERE d.a = 2 ORDER BY c.a;
+--NULL	NULL
+--NULL	NULL
+--1	1
+--1	1
+--2	1
+--2	1
+--2	1
+--2	1
+--3	NULL
+--3	NULL
+
+DROP TABLE c1;
+DROP TABLE c2;